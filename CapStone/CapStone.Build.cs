@@ -14,10 +14,12 @@ public class CapStone : ModuleRules
 			"Engine",
 			"InputCore",
 			"EnhancedInput",
+			"AnimationCore",
 			"LearningAgents",
 			"LearningAgentsTraining",
 			"Learning",
-			"LearningTraining"
+			"LearningTraining",
+			"Json"
 		});
 	}
 }
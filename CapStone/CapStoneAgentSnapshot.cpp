@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneAgentSnapshot.h"
+
+#include "CapStoneCharacter.h"
+#include "LearningAgentsManager.h"
+
+void FCapStoneAgentSnapshot::Reset(int32 MaxAgentNum)
+{
+	const int32 EnemySlotNum = MaxAgentNum * MaxEnemyNum;
+
+	Characters.SetNumZeroed(MaxAgentNum);
+	Valid.SetNumZeroed(MaxAgentNum);
+
+	Transform.SetNum(MaxAgentNum);
+	Location.SetNum(MaxAgentNum);
+	Forward.SetNum(MaxAgentNum);
+	Rotation.SetNum(MaxAgentNum);
+
+	RightPointLocation.SetNum(MaxAgentNum);
+	RightPointRotation.SetNum(MaxAgentNum);
+	LeftPointLocation.SetNum(MaxAgentNum);
+	LeftPointRotation.SetNum(MaxAgentNum);
+
+	Health.SetNumZeroed(MaxAgentNum);
+	MaxHealth.SetNumZeroed(MaxAgentNum);
+	Stamina.SetNumZeroed(MaxAgentNum);
+	MaxStamina.SetNumZeroed(MaxAgentNum);
+	Hit.SetNumZeroed(MaxAgentNum);
+	Dead.SetNumZeroed(MaxAgentNum);
+
+	MaxEnemyDistance.SetNumZeroed(MaxAgentNum);
+	EnemyHealthRewardScale.SetNumZeroed(MaxAgentNum);
+	MyHealthRewardScale.SetNumZeroed(MaxAgentNum);
+	StaminaRewardScale.SetNumZeroed(MaxAgentNum);
+
+	EnemyNum.SetNumZeroed(MaxAgentNum);
+	EnemyCharacter.SetNumZeroed(EnemySlotNum);
+	EnemyLocation.SetNum(EnemySlotNum);
+	EnemyDirection.SetNum(EnemySlotNum);
+	EnemyHealth.SetNumZeroed(EnemySlotNum);
+	EnemyMaxHealth.SetNumZeroed(EnemySlotNum);
+	EnemyDead.SetNumZeroed(EnemySlotNum);
+}
+
+void FCapStoneAgentSnapshot::Update(const TArray<ACapStoneCharacter*>& InCharacters, const ULearningAgentsManager* Manager)
+{
+	if (!Manager)
+	{
+		return;
+	}
+
+	if (GetMaxAgentNum() != Manager->GetMaxAgentNum())
+	{
+		Reset(Manager->GetMaxAgentNum());
+	}
+
+	++Version;
+
+	for (int32 AgentId = 0; AgentId < Valid.Num(); ++AgentId)
+	{
+		Valid[AgentId] = false;
+		Characters[AgentId] = nullptr;
+	}
+
+	for (ACapStoneCharacter* Character : InCharacters)
+	{
+		if (!Character || Character->GetAgentManager() != Manager)
+		{
+			continue;
+		}
+
+		UpdateAgent(Character);
+	}
+}
+
+void FCapStoneAgentSnapshot::UpdateAgent(ACapStoneCharacter* Character)
+{
+	const int32 AgentId = Character->GetAgentId();
+	if (!Valid.IsValidIndex(AgentId))
+	{
+		return;
+	}
+
+	++Version;
+
+	Characters[AgentId] = Character;
+	Valid[AgentId] = true;
+
+	Transform[AgentId] = Character->GetActorTransform();
+	Location[AgentId] = Transform[AgentId].GetLocation();
+	Forward[AgentId] = Transform[AgentId].GetUnitAxis(EAxis::X);
+	Rotation[AgentId] = Transform[AgentId].Rotator();
+
+	const FTransform& RightTransform = Character->GetRightPoint()->GetComponentTransform();
+	const FTransform& LeftTransform = Character->GetLeftPoint()->GetComponentTransform();
+	RightPointLocation[AgentId] = RightTransform.GetLocation();
+	RightPointRotation[AgentId] = RightTransform.Rotator();
+	LeftPointLocation[AgentId] = LeftTransform.GetLocation();
+	LeftPointRotation[AgentId] = LeftTransform.Rotator();
+
+	Health[AgentId] = Character->GetHealth();
+	MaxHealth[AgentId] = Character->GetMaxHealth();
+	Stamina[AgentId] = Character->GetStamina();
+	MaxStamina[AgentId] = Character->GetMaxStamina();
+	Hit[AgentId] = Character->IsHit();
+	Dead[AgentId] = Character->GetIsDead();
+
+	MaxEnemyDistance[AgentId] = Character->GetMaxEnemyDistance();
+	EnemyHealthRewardScale[AgentId] = Character->GetEHRScale();
+	MyHealthRewardScale[AgentId] = Character->GetMHRScale();
+	StaminaRewardScale[AgentId] = Character->GetSRScale();
+
+	const TArray<ACapStoneCharacter*>& Enemies = Character->GetEnemyCharacters();
+	const TArray<FVector>& Locations = Character->GetEnemyLocation();
+	const TArray<FVector>& Directions = Character->GetEnemyDirection();
+	const int32 Count = FMath::Min3(Enemies.Num(), Locations.Num(), MaxEnemyNum);
+
+	EnemyNum[AgentId] = Count;
+	for (int32 Enemy = 0; Enemy < Count; ++Enemy)
+	{
+		const int32 Slot = EnemyIndex(AgentId, Enemy);
+		EnemyCharacter[Slot] = Enemies[Enemy];
+		EnemyLocation[Slot] = Locations[Enemy];
+		EnemyDirection[Slot] = Directions[Enemy];
+		EnemyHealth[Slot] = Enemies[Enemy]->GetHealth();
+		EnemyMaxHealth[Slot] = Enemies[Enemy]->GetMaxHealth();
+		EnemyDead[Slot] = Enemies[Enemy]->GetIsDead();
+	}
+}
+
+void FCapStoneAgentSnapshot::UpdateResetAgent(ACapStoneCharacter* Character)
+{
+	UpdateAgent(Character);
+	UpdateEnemySlots(Character);
+
+	// 리셋은 가장 가까운 적을 살리고 체력을 채운다
+	for (ACapStoneCharacter* Enemy : Character->GetEnemyCharacters())
+	{
+		const int32 EnemyId = Enemy ? Enemy->GetAgentId() : INDEX_NONE;
+		if (IsValid(EnemyId) && Characters[EnemyId] == Enemy)
+		{
+			Health[EnemyId] = Enemy->GetHealth();
+			Dead[EnemyId] = Enemy->GetIsDead();
+		}
+		UpdateEnemySlots(Enemy);
+	}
+}
+
+void FCapStoneAgentSnapshot::UpdateEnemySlots(const ACapStoneCharacter* Target)
+{
+	if (!Target)
+	{
+		return;
+	}
+
+	const FVector TargetLocation = Target->GetActorLocation();
+	const FVector TargetForward = Target->GetActorForwardVector();
+
+	for (int32 AgentId = 0; AgentId < Valid.Num(); ++AgentId)
+	{
+		if (!Valid[AgentId])
+		{
+			continue;
+		}
+
+		for (int32 Enemy = 0; Enemy < EnemyNum[AgentId]; ++Enemy)
+		{
+			const int32 Slot = EnemyIndex(AgentId, Enemy);
+			if (EnemyCharacter[Slot] != Target)
+			{
+				continue;
+			}
+
+			EnemyLocation[Slot] = TargetLocation;
+			EnemyDirection[Slot] = TargetForward;
+			EnemyHealth[Slot] = Target->GetHealth();
+			EnemyMaxHealth[Slot] = Target->GetMaxHealth();
+			EnemyDead[Slot] = Target->GetIsDead();
+		}
+	}
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CapStoneEnemySubsystem.h"
+
+#include "CoreMinimal.h"
+
+class ACapStoneCharacter;
+class ULearningAgentsManager;
+
+/**
+ * AgentId 로 index 되는 structure-of-arrays 스냅샷.
+ * AMyLearningManager 가 스텝마다 한 번 채우고 interactor 와 training environment 는 여기서만 읽는다.
+ * 적 정보는 AgentId * MaxEnemyNum + EnemyIndex 위치에 들어간다.
+ */
+struct CAPSTONE_API FCapStoneAgentSnapshot
+{
+	static constexpr int32 MaxEnemyNum = UCapStoneEnemySubsystem::MaxEnemyNum;
+
+	/** Sizes every array for MaxAgentNum agents. Only reallocates when the agent count grows. */
+	void Reset(int32 MaxAgentNum);
+
+	/** Copies the state of every character registered with Manager into the arrays. */
+	void Update(const TArray<ACapStoneCharacter*>& InCharacters, const ULearningAgentsManager* Manager);
+
+	/** Re-reads a single character's own row. */
+	void UpdateAgent(ACapStoneCharacter* Character);
+
+	/**
+	 * After Character was reset in the middle of a step: re-reads its row, the health of the enemies the reset revived,
+	 * and every enemy slot of other agents that points at any of them.
+	 */
+	void UpdateResetAgent(ACapStoneCharacter* Character);
+
+	bool IsValid(int32 AgentId) const { return Valid.IsValidIndex(AgentId) && Valid[AgentId]; }
+
+	int32 GetMaxAgentNum() const { return Valid.Num(); }
+
+	/** Changes whenever Update or UpdateAgent writes to the arrays, so readers can tell a fresh snapshot from one they already used. */
+	uint32 GetVersion() const { return Version; }
+
+	static int32 EnemyIndex(int32 AgentId, int32 Enemy) { return AgentId * MaxEnemyNum + Enemy; }
+
+	TArray<ACapStoneCharacter*> Characters;
+	TArray<bool> Valid;
+
+	TArray<FTransform> Transform;
+	TArray<FVector> Location;
+	TArray<FVector> Forward;
+	TArray<FRotator> Rotation;
+
+	TArray<FVector> RightPointLocation;
+	TArray<FRotator> RightPointRotation;
+	TArray<FVector> LeftPointLocation;
+	TArray<FRotator> LeftPointRotation;
+
+	TArray<float> Health;
+	TArray<float> MaxHealth;
+	TArray<int32> Stamina;
+	TArray<int32> MaxStamina;
+	TArray<bool> Hit;
+	TArray<bool> Dead;
+
+	TArray<float> MaxEnemyDistance;
+	TArray<float> EnemyHealthRewardScale;
+	TArray<float> MyHealthRewardScale;
+	TArray<float> StaminaRewardScale;
+
+	// 가까운 순서의 적 정보
+	TArray<int32> EnemyNum;
+	TArray<ACapStoneCharacter*> EnemyCharacter;
+	TArray<FVector> EnemyLocation;
+	TArray<FVector> EnemyDirection;
+	TArray<float> EnemyHealth;
+	TArray<float> EnemyMaxHealth;
+	TArray<bool> EnemyDead;
+
+private:
+	/** Rewrites the enemy slots of every agent that see Target */
+	void UpdateEnemySlots(const ACapStoneCharacter* Target);
+
+	uint32 Version = 0;
+};
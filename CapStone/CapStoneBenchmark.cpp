@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneBenchmark.h"
+
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformMemory.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+#include "CapStoneCharacter.h"
+
+bool FCapStoneBenchmark::ParseCommandLine()
+{
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneBenchmarkReport="), ReportPath);
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneBenchmarkSteps="), StepNum);
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneBenchmarkWarmup="), WarmupStepNum);
+	bTraining = FParse::Param(FCommandLine::Get(), TEXT("CapStoneBenchmarkTraining"));
+	StepNum = FMath::Max(StepNum, 1);
+	WarmupStepNum = FMath::Max(WarmupStepNum, 0);
+
+	return IsEnabled();
+}
+
+void FCapStoneBenchmark::Begin()
+{
+	UsedMemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+	StepCount = 0;
+	GameThreadSeconds = 0.0;
+	bFinished = false;
+}
+
+void FCapStoneBenchmark::AddStep(double StepSeconds)
+{
+	++StepCount;
+
+	// warmup 이 끝나는 스텝부터 잰다
+	if (StepCount == WarmupStepNum + 1)
+	{
+		MeasureStartTime = FPlatformTime::Seconds();
+	}
+	if (StepCount > WarmupStepNum)
+	{
+		GameThreadSeconds += StepSeconds;
+	}
+}
+
+void FCapStoneBenchmark::TryFinish(const TArray<ACapStoneCharacter*>& Characters, int32 AgentNum)
+{
+	if (bFinished || StepCount < WarmupStepNum + StepNum)
+	{
+		return;
+	}
+	bFinished = true;
+
+	const double WallSeconds = FMath::Max(FPlatformTime::Seconds() - MeasureStartTime, UE_DOUBLE_SMALL_NUMBER);
+	const uint64 UsedMemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+
+	// 모든 캐릭터를 한 번씩 리셋해서 평균 비용을 잰다
+	int32 ResetNum = 0;
+	const double ResetStart = FPlatformTime::Seconds();
+	for (ACapStoneCharacter* Character : Characters)
+	{
+		if (Character)
+		{
+			Character->RLResetCharacter();
+			++ResetNum;
+		}
+	}
+	const double ResetSeconds = FPlatformTime::Seconds() - ResetStart;
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("mode"), bTraining ? TEXT("training") : TEXT("inference"));
+	Report->SetNumberField(TEXT("agents"), AgentNum);
+	Report->SetNumberField(TEXT("steps"), StepNum);
+	Report->SetNumberField(TEXT("seed"), RunSeed);
+	Report->SetNumberField(TEXT("steps_per_sec"), StepNum / WallSeconds);
+	Report->SetNumberField(TEXT("env_steps_per_sec"), StepNum * AgentNum / WallSeconds);
+	Report->SetNumberField(TEXT("game_thread_ms_per_step"), GameThreadSeconds * 1000.0 / StepNum);
+	Report->SetNumberField(TEXT("wall_ms_per_step"), WallSeconds * 1000.0 / StepNum);
+	Report->SetNumberField(TEXT("memory_bytes"), UsedMemoryAfter > UsedMemoryBefore ? double(UsedMemoryAfter - UsedMemoryBefore) : 0.0);
+	Report->SetNumberField(TEXT("reset_ms_per_agent"), ResetNum > 0 ? ResetSeconds * 1000.0 / ResetNum : 0.0);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Json, *ReportPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not write benchmark report %s."), *ReportPath);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Benchmark (%s): %d agents, %.1f steps/sec, %.3f ms game thread per step"),
+		bTraining ? TEXT("training") : TEXT("inference"), AgentNum, StepNum / WallSeconds, GameThreadSeconds * 1000.0 / StepNum);
+
+	FPlatformMisc::RequestExit(false, TEXT("FCapStoneBenchmark::TryFinish"));
+}
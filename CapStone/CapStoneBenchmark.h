@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ACapStoneCharacter;
+
+/**
+ * AMyLearningManager 하나의 benchmark 실행.
+ * -CapStoneBenchmarkReport=<path> 로 켜지고 warmup 후 StepNum 스텝을 재서 JSON 한 개를 쓴 뒤 게임을 끝낸다.
+ * 기본은 학습 process 없는 inference 이고, -CapStoneBenchmarkTraining 이면 trainer 와 함께 RunTraining 경로를 잰다.
+ * 메모리는 실행 전체의 증가량만 쓴다. 고정 비용이 섞여 있으므로 agent 당 비용은 commandlet 이 agent 수에 대한 기울기로 구한다.
+ * UCapStoneBenchmarkCommandlet 이 agent 수마다 이 실행을 하나씩 띄운다.
+ */
+struct CAPSTONE_API FCapStoneBenchmark
+{
+	/** Reads the -CapStoneBenchmark* switches. Returns false when benchmarking is off. */
+	bool ParseCommandLine();
+
+	bool IsEnabled() const { return !ReportPath.IsEmpty(); }
+	bool IsFinished() const { return bFinished; }
+
+	/** Call before the arenas are spawned so the memory delta covers them */
+	void Begin();
+
+	/** Call once per manager tick with the game-thread time of the step */
+	void AddStep(double StepSeconds);
+
+	/** Once the measured steps are done: times one RLResetCharacter per character, writes the report and requests exit. AgentNum is the spawned count. */
+	void TryFinish(const TArray<ACapStoneCharacter*>& Characters, int32 AgentNum);
+
+	/** -CapStoneBenchmarkTraining: measure RunTraining instead of RunInference */
+	bool IsTraining() const { return IsEnabled() && bTraining; }
+
+	int32 WarmupStepNum = 60;
+	int32 StepNum = 600;
+
+	/** Written to the report so runs can be compared episode for episode */
+	int32 RunSeed = 0;
+
+private:
+	FString ReportPath;
+	bool bTraining = false;
+
+	int32 StepCount = 0;
+	double MeasureStartTime = 0.0;
+	double GameThreadSeconds = 0.0;
+	uint64 UsedMemoryBefore = 0;
+	bool bFinished = false;
+};
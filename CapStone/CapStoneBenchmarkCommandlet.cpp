@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneBenchmarkCommandlet.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformProcess.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+
+UCapStoneBenchmarkCommandlet::UCapStoneBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UCapStoneBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString Map;
+	if (!FParse::Value(*Params, TEXT("Map="), Map))
+	{
+		UE_LOG(LogTemp, Error, TEXT("CapStoneBenchmark: -Map= is required."));
+		return 1;
+	}
+
+	FString AgentCountsString = TEXT("2,8,32,128,256");
+	FString ModesString = TEXT("inference,training");
+	int32 Steps = 600;
+	int32 Warmup = 60;
+	int32 Seed = 1;
+	FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmark") / TEXT("Report.json");
+	FString BaselinePath;
+	float Threshold = 0.1f;
+
+	FParse::Value(*Params, TEXT("AgentCounts="), AgentCountsString, false);
+	FParse::Value(*Params, TEXT("Modes="), ModesString, false);
+	FParse::Value(*Params, TEXT("Steps="), Steps);
+	FParse::Value(*Params, TEXT("Warmup="), Warmup);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("Threshold="), Threshold);
+
+	TArray<FString> AgentCountStrings;
+	AgentCountsString.ParseIntoArray(AgentCountStrings, TEXT(","));
+
+	TArray<FString> Modes;
+	ModesString.ParseIntoArray(Modes, TEXT(","));
+	for (const FString& Mode : Modes)
+	{
+		if (Mode != TEXT("inference") && Mode != TEXT("training"))
+		{
+			UE_LOG(LogTemp, Error, TEXT("CapStoneBenchmark: unknown mode %s, expected inference or training."), *Mode);
+			return 1;
+		}
+	}
+
+	const FString OutputDir = FPaths::GetPath(ReportPath);
+	TArray<TSharedPtr<FJsonValue>> Runs;
+
+	for (const FString& Mode : Modes)
+	{
+		for (const FString& AgentCountString : AgentCountStrings)
+		{
+			const int32 AgentCount = FCString::Atoi(*AgentCountString);
+			if (AgentCount <= 0)
+			{
+				continue;
+			}
+
+			TSharedPtr<FJsonObject> Run = RunOne(Map, Mode, AgentCount, Steps, Warmup, Seed, OutputDir);
+			if (!Run)
+			{
+				UE_LOG(LogTemp, Error, TEXT("CapStoneBenchmark: %s run with %d agents failed."), *Mode, AgentCount);
+				return 1;
+			}
+
+			const int32 SpawnedNum = Run->GetIntegerField(TEXT("agents"));
+			if (SpawnedNum != AgentCount)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("CapStoneBenchmark: requested %d agents, %d were spawned. The run is recorded as %d."),
+					AgentCount, SpawnedNum, SpawnedNum);
+			}
+			Run->SetNumberField(TEXT("requested_agents"), AgentCount);
+			Runs.Add(MakeShared<FJsonValueObject>(Run));
+		}
+	}
+
+	TSharedRef<FJsonObject> MemoryFits = MakeShared<FJsonObject>();
+	for (const FString& Mode : Modes)
+	{
+		if (TSharedPtr<FJsonObject> Fit = FitMemory(Runs, Mode))
+		{
+			MemoryFits->SetObjectField(Mode, Fit);
+		}
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("map"), Map);
+	Report->SetStringField(TEXT("date"), FDateTime::UtcNow().ToIso8601());
+	Report->SetArrayField(TEXT("runs"), Runs);
+	Report->SetObjectField(TEXT("memory"), MemoryFits);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+	if (!FFileHelper::SaveStringToFile(Json, *ReportPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("CapStoneBenchmark: could not write %s."), *ReportPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("CapStoneBenchmark: wrote %s."), *ReportPath);
+
+	if (!BaselinePath.IsEmpty() && CompareWithBaseline(Runs, BaselinePath, Threshold) > 0)
+	{
+		return 1;
+	}
+	return 0;
+}
+
+TSharedPtr<FJsonObject> UCapStoneBenchmarkCommandlet::RunOne(
+	const FString& Map, const FString& Mode, int32 AgentCount, int32 Steps, int32 Warmup, int32 Seed, const FString& OutputDir) const
+{
+	// arena 하나에 agent, opponent 두 명이 들어가므로 홀수는 올린다
+	const int32 ArenaNum = FMath::Max(FMath::DivideAndRoundUp(AgentCount, 2), 1);
+	const bool bTraining = Mode == TEXT("training");
+	const FString RunReportPath = FPaths::ConvertRelativePathToFull(
+		OutputDir / FString::Printf(TEXT("Run_%s_%d.json"), *Mode, AgentCount));
+	IFileManager::Get().Delete(*RunReportPath, false, false, true);
+
+	const FString Args = FString::Printf(
+		TEXT("\"%s\" %s -game -nullrhi -nosound -unattended -log -CapStoneHeadless -CapStoneArenaNum=%d -CapStoneSeed=%d ")
+		TEXT("-CapStoneBenchmarkSteps=%d -CapStoneBenchmarkWarmup=%d -CapStoneBenchmarkReport=\"%s\"%s"),
+		*FPaths::GetProjectFilePath(), *Map, ArenaNum, Seed, Steps, Warmup, *RunReportPath,
+		bTraining ? TEXT(" -CapStoneBenchmarkTraining -CapStoneMockTrainer") : TEXT(""));
+
+	UE_LOG(LogTemp, Display, TEXT("CapStoneBenchmark: %s, %d agents requested (%d arenas)"), *Mode, AgentCount, ArenaNum);
+
+	FProcHandle Process = FPlatformProcess::CreateProc(
+		FPlatformProcess::ExecutablePath(), *Args, true, true, true, nullptr, 0, nullptr, nullptr);
+	if (!Process.IsValid())
+	{
+		return nullptr;
+	}
+	FPlatformProcess::WaitForProc(Process);
+	FPlatformProcess::CloseProc(Process);
+
+	FString Json;
+	if (!FFileHelper::LoadFileToString(Json, *RunReportPath))
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FJsonObject> Run;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+	if (!FJsonSerializer::Deserialize(Reader, Run))
+	{
+		return nullptr;
+	}
+	return Run;
+}
+
+TSharedPtr<FJsonObject> UCapStoneBenchmarkCommandlet::FitMemory(const TArray<TSharedPtr<FJsonValue>>& Runs, const FString& Mode) const
+{
+	double SumX = 0.0, SumY = 0.0, SumXX = 0.0, SumXY = 0.0;
+	int32 RunNum = 0;
+	TSet<int32> AgentCounts;
+
+	for (const TSharedPtr<FJsonValue>& Value : Runs)
+	{
+		const TSharedPtr<FJsonObject>& Run = Value->AsObject();
+		if (Run->GetStringField(TEXT("mode")) != Mode)
+		{
+			continue;
+		}
+
+		const int32 AgentNum = Run->GetIntegerField(TEXT("agents"));
+		const double X = AgentNum;
+		const double Y = Run->GetNumberField(TEXT("memory_bytes"));
+		SumX += X;
+		SumY += Y;
+		SumXX += X * X;
+		SumXY += X * Y;
+		AgentCounts.Add(AgentNum);
+		++RunNum;
+	}
+
+	// agent 수가 하나뿐이면 기울기와 고정 비용을 나눌 수 없다
+	const double Denominator = RunNum * SumXX - SumX * SumX;
+	if (AgentCounts.Num() < 2 || Denominator <= 0.0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CapStoneBenchmark: %s needs at least two agent counts to fit memory per agent."), *Mode);
+		return nullptr;
+	}
+
+	const double BytesPerAgent = (RunNum * SumXY - SumX * SumY) / Denominator;
+	const double FixedBytes = (SumY - BytesPerAgent * SumX) / RunNum;
+
+	TSharedPtr<FJsonObject> Fit = MakeShared<FJsonObject>();
+	Fit->SetNumberField(TEXT("bytes_per_agent"), BytesPerAgent);
+	Fit->SetNumberField(TEXT("fixed_bytes"), FixedBytes);
+
+	UE_LOG(LogTemp, Display, TEXT("CapStoneBenchmark: %s memory %.0f bytes per agent, %.0f bytes fixed."), *Mode, BytesPerAgent, FixedBytes);
+	return Fit;
+}
+
+int32 UCapStoneBenchmarkCommandlet::CompareWithBaseline(
+	const TArray<TSharedPtr<FJsonValue>>& Runs, const FString& BaselinePath, float Threshold) const
+{
+	FString Json;
+	TSharedPtr<FJsonObject> Baseline;
+	if (!FFileHelper::LoadFileToString(Json, *BaselinePath)
+		|| !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Baseline))
+	{
+		UE_LOG(LogTemp, Error, TEXT("CapStoneBenchmark: could not read baseline %s."), *BaselinePath);
+		return 1;
+	}
+
+	// 같은 mode, 생성된 agent 수끼리 steps/sec 비교. mode 가 없는 예전 report 는 inference 다
+	auto MakeKey = [](const FJsonObject& Run)
+	{
+		FString Mode;
+		if (!Run.TryGetStringField(TEXT("mode"), Mode))
+		{
+			Mode = TEXT("inference");
+		}
+		return FString::Printf(TEXT("%s %d agents"), *Mode, (int32)Run.GetIntegerField(TEXT("agents")));
+	};
+
+	TMap<FString, double> BaselineStepsPerSec;
+	for (const TSharedPtr<FJsonValue>& Value : Baseline->GetArrayField(TEXT("runs")))
+	{
+		const TSharedPtr<FJsonObject>& Run = Value->AsObject();
+		BaselineStepsPerSec.Add(MakeKey(*Run), Run->GetNumberField(TEXT("steps_per_sec")));
+	}
+
+	int32 RegressionNum = 0;
+	for (const TSharedPtr<FJsonValue>& Value : Runs)
+	{
+		const TSharedPtr<FJsonObject>& Run = Value->AsObject();
+		const FString Key = MakeKey(*Run);
+		const double* Expected = BaselineStepsPerSec.Find(Key);
+		if (!Expected)
+		{
+			continue;
+		}
+
+		const double Current = Run->GetNumberField(TEXT("steps_per_sec"));
+		if (Current < *Expected * (1.0 - Threshold))
+		{
+			UE_LOG(LogTemp, Error, TEXT("CapStoneBenchmark: %s regressed, %.1f steps/sec (baseline %.1f)."),
+				*Key, Current, *Expected);
+			++RegressionNum;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("CapStoneBenchmark: %s ok, %.1f steps/sec (baseline %.1f)."),
+				*Key, Current, *Expected);
+		}
+	}
+	return RegressionNum;
+}
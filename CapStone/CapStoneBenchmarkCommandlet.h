@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CapStoneBenchmarkCommandlet.generated.h"
+
+class FJsonObject;
+class FJsonValue;
+
+/**
+ * Agent 수를 바꿔 가며 headless 게임 process 를 하나씩 띄워 AMyLearningManager 의 처리량을 잰다.
+ *
+ * UnrealEditor-Cmd CapStone.uproject -run=CapStoneBenchmark -Map=/Game/Maps/Benchmark
+ *     [-AgentCounts=2,8,32,128,256] [-Modes=inference,training] [-Steps=600] [-Warmup=60] [-Seed=1]
+ *     [-Report=Saved/Benchmark/Report.json] [-Baseline=<report.json>] [-Threshold=0.1]
+ *
+ * Arena 하나에 두 명이 들어가므로 홀수 agent 수는 올려서 생성되고, run 은 실제로 생성된 agent 수로 기록된다.
+ * training mode 는 -CapStoneMockTrainer 로 CapStoneMockTrainer 와 함께 돌아서 Python 없이 RunTraining 경로를 잰다.
+ * 모든 run 은 같은 -Seed 로 돌아서 reset 위치가 매번 같다.
+ * Mode 마다 run 들의 메모리 증가량을 agent 수에 대해 직선으로 맞춰서 기울기를 agent 당 메모리, 절편을 고정 비용으로 쓴다.
+ * Baseline 이 있으면 같은 mode, agent 수에서 steps/sec 가 Threshold 비율 넘게 떨어진 run 이 있을 때 1 을 돌려준다.
+ */
+UCLASS()
+class CAPSTONE_API UCapStoneBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCapStoneBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/** Runs one headless game process and returns its report, or nullptr */
+	TSharedPtr<FJsonObject> RunOne(const FString& Map, const FString& Mode, int32 AgentCount, int32 Steps, int32 Warmup, int32 Seed, const FString& OutputDir) const;
+
+	/** Least-squares fit of memory_bytes against agents over the runs of Mode, or nullptr with fewer than two agent counts */
+	TSharedPtr<FJsonObject> FitMemory(const TArray<TSharedPtr<FJsonValue>>& Runs, const FString& Mode) const;
+
+	/** Number of regressions against the baseline report */
+	int32 CompareWithBaseline(const TArray<TSharedPtr<FJsonValue>>& Runs, const FString& BaselinePath, float Threshold) const;
+};
@@ -17,6 +17,9 @@
 #include "Kismet/GameplayStatics.h"
 #include "Math/UnrealMathUtility.h"
 #include "LearningAgentsManager.h"
+#include "CapStoneEnemySubsystem.h"
+#include "CapStoneCombatSubsystem.h"
+#include "MyLearningManager.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
@@ -318,54 +321,145 @@ void ACapStoneCharacter::RLLeftPointMove(FVector LeftOffset){
 	}
 }
 
+namespace
+{
+	/** Same result as AddLocalOffset per reachable axis followed by AddLocalRotation per axis, without touching the component */
+	void AccumulateHandStep(
+		FVector& InOutLocation, FQuat& InOutRotation, const FTransform& ParentTransform,
+		const FVector& Origin, float MaxRange,
+		const FIntVector& Move, const FIntVector& Rotate, float LocationAmount, float RotationAmount)
+	{
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Move[Axis] == 0)
+			{
+				continue;
+			}
+
+			FVector Offset = FVector::ZeroVector;
+			Offset[Axis] = Move[Axis] * LocationAmount;
+			const FVector RelativeOffset = InOutRotation.RotateVector(Offset);
+
+			const FVector NewLocation = ParentTransform.TransformPosition(InOutLocation + RelativeOffset);
+			if (FVector::Dist(Origin, NewLocation) <= MaxRange)
+			{
+				InOutLocation += RelativeOffset;
+			}
+		}
+
+		// X, Y, Z 축은 FRotator 의 Pitch, Yaw, Roll
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Rotate[Axis] == 0)
+			{
+				continue;
+			}
+
+			const float Amount = Rotate[Axis] * RotationAmount;
+			const FRotator Delta(Axis == 0 ? Amount : 0.f, Axis == 1 ? Amount : 0.f, Axis == 2 ? Amount : 0.f);
+			InOutRotation = InOutRotation * Delta.Quaternion();
+		}
+	}
+}
+
+void ACapStoneCharacter::RLApplyHandSteps(
+	const FIntVector& RightMove, const FIntVector& RightRotate,
+	const FIntVector& LeftMove, const FIntVector& LeftRotate,
+	float LocationAmount, float RotationAmount)
+{
+	const bool bRight = RightMove != FIntVector::ZeroValue || RightRotate != FIntVector::ZeroValue;
+	const bool bLeft = LeftMove != FIntVector::ZeroValue || LeftRotate != FIntVector::ZeroValue;
+	if (!bRight && !bLeft)
+	{
+		return;
+	}
+
+	// 스텝당 한 번만 읽는다
+	const FVector Origin = GetMesh()->GetSocketLocation("neck_01");
+	const FTransform& ParentTransform = GetMesh()->GetComponentTransform();
+
+	if (bRight)
+	{
+		FVector Location = RightPoint->GetRelativeLocation();
+		FQuat Rotation = RightPoint->GetRelativeRotation().Quaternion();
+		AccumulateHandStep(Location, Rotation, ParentTransform, Origin, MaxRange, RightMove, RightRotate, LocationAmount, RotationAmount);
+		RightPoint->SetRelativeLocationAndRotation(Location, Rotation);
+	}
+
+	if (bLeft)
+	{
+		FVector Location = LeftPoint->GetRelativeLocation();
+		FQuat Rotation = LeftPoint->GetRelativeRotation().Quaternion();
+		AccumulateHandStep(Location, Rotation, ParentTransform, Origin, MaxRange, LeftMove, LeftRotate, LocationAmount, RotationAmount);
+		LeftPoint->SetRelativeLocationAndRotation(Location, Rotation);
+	}
+}
+
 void ACapStoneCharacter::MakeEnemyInformation()
 {
-	EnemyCharacters.Empty();
-	EnemyLocation.Empty();
-	EnemyDirection.Empty();
+	EnemyLocation.Reset();
+	EnemyDirection.Reset();
+
+	UCapStoneEnemySubsystem* EnemySubsystem = GetWorld()->GetSubsystem<UCapStoneEnemySubsystem>();
+	if (!EnemySubsystem)
+	{
+		EnemyCharacters.Reset();
+		return;
+	}
 
-	TArray<AActor*> EnemyActors;
-	UGameplayStatics::GetAllActorsOfClass(
-		GetWorld(), ACapStoneCharacter::StaticClass(), EnemyActors);
+	// 거리 기준으로 정렬된 가장 가까운 적들
+	EnemySubsystem->QueryNearestEnemies(this, UCapStoneEnemySubsystem::MaxEnemyNum, EnemyCharacters);
 
-	struct FEnemyInfo
+	for (const ACapStoneCharacter* Enemy : EnemyCharacters)
 	{
-		ACapStoneCharacter* EnemyChar;
-		FVector Location;
-		FVector Direction;
-		float Distance;
+		EnemyLocation.Add(Enemy->GetActorLocation());
+		EnemyDirection.Add(Enemy->GetActorForwardVector());
+	}
+}
 
-		FEnemyInfo(ACapStoneCharacter* InChar, const FVector& InLoc, const FVector& InDir, float InDist)
-			: EnemyChar(InChar), Location(InLoc), Direction(InDir), Distance(InDist) {}
-	};
+void ACapStoneCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
 
-	TArray<FEnemyInfo> EnemyInfoList;
+	// 다른 캐릭터의 BeginPlay 에서도 보이도록 BeginPlay 전에 등록
+	if (UCapStoneEnemySubsystem* EnemySubsystem = GetWorld()->GetSubsystem<UCapStoneEnemySubsystem>())
+	{
+		EnemySubsystem->RegisterCharacter(this);
+	}
+}
 
-	for (AActor* Actor : EnemyActors)
+namespace
+{
+	/** Async inference of AMyLearningManager must not run while its agent set changes */
+	void FlushManagerTasks(ULearningAgentsManager* Manager)
 	{
-		ACapStoneCharacter* OtherChar = Cast<ACapStoneCharacter>(Actor);
-		if (OtherChar && OtherChar != this && OtherChar->TeamID != this->TeamID)
+		if (AMyLearningManager* Owner = Cast<AMyLearningManager>(Manager->GetOwner()))
 		{
-			FVector Location = OtherChar->GetActorLocation();
-			float Distance = FVector::Dist(GetActorLocation(), Location);
-
-			EnemyInfoList.Add(FEnemyInfo(OtherChar, Location, OtherChar->GetActorForwardVector(), Distance));
+			Owner->FlushAgentTasks();
 		}
 	}
+}
 
-	// 거리 기준으로 정렬 (오름차순)
-	EnemyInfoList.Sort([](const FEnemyInfo& A, const FEnemyInfo& B)
+void ACapStoneCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCapStoneEnemySubsystem* EnemySubsystem = GetWorld()->GetSubsystem<UCapStoneEnemySubsystem>())
+	{
+		EnemySubsystem->UnregisterCharacter(this);
+	}
+	if (UCapStoneCombatSubsystem* CombatSubsystem = GetWorld()->GetSubsystem<UCapStoneCombatSubsystem>())
 	{
-		return A.Distance < B.Distance;
-	});
+		CombatSubsystem->UnregisterCharacter(this);
+	}
 
-	// 정렬된 정보 복사
-	for (const FEnemyInfo& Info : EnemyInfoList)
+	// 레벨이 끝날 때는 manager 가 먼저 정리되므로 게임 중에 없어지는 캐릭터만 뺀다
+	if (EndPlayReason == EEndPlayReason::Destroyed && IsValid(AgentManager) && AgentId != INDEX_NONE)
 	{
-		EnemyCharacters.Add(Info.EnemyChar);
-		EnemyLocation.Add(Info.Location);
-		EnemyDirection.Add(Info.Direction);
+		FlushManagerTasks(AgentManager);
+		AgentManager->RemoveAgent(AgentId);
+		AgentId = INDEX_NONE;
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ACapStoneCharacter::BeginPlay()
@@ -389,15 +483,16 @@ void ACapStoneCharacter::BeginPlay()
 	if (HandRight)
 	{
 		AWeapon* HandRightActor = GetWorld()->SpawnActor<AWeapon>(HandRight, HandRightLocation, HandRightRotation, SpawnParams);
+		RightWeapon = HandRightActor;
 		if (HandRightActor)
 		{
 			HandRightActor->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, FName("hand_rSocket"));
+
+			if (HandRightActor->BoxComponent)
+			{
+				HandRightActor->BoxComponent->OnComponentHit.AddDynamic(this, &ACapStoneCharacter::OnMeshHit);
+			}
 		}
-		
-		if (HandRightActor->BoxComponent)
-        {
-            HandRightActor->BoxComponent->OnComponentHit.AddDynamic(this, &ACapStoneCharacter::OnMeshHit);
-        }
 	}
 	else
 	{
@@ -407,9 +502,15 @@ void ACapStoneCharacter::BeginPlay()
 	if (HandLeft)
 	{
 		AWeapon* HandLeftActor = GetWorld()->SpawnActor<AWeapon>(HandLeft, HandLeftLocation, HandLeftRotation, SpawnParams);
+		LeftWeapon = HandLeftActor;
 		if (HandLeftActor)
 		{
 			HandLeftActor->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, FName("hand_lSocket"));
+
+			if (HandLeftActor->BoxComponent)
+			{
+				HandLeftActor->BoxComponent->OnComponentHit.AddDynamic(this, &ACapStoneCharacter::OnMeshHit);
+			}
 		}
 	}
 	else
@@ -417,50 +518,79 @@ void ACapStoneCharacter::BeginPlay()
 		UE_LOG(LogTemp, Error, TEXT("HandLeft is invalid or not an Actor class"));
 	}
 
-	// LearningAgentsManager 찾기
-	TArray<AActor*> Managers;
-	UGameplayStatics::GetAllActorsWithTag(
-		GetWorld(), ManagerTag, Managers
-	);
-	for (AActor* Actor : Managers)
-    {
-        ULearningAgentsManager* Manager = 
-		Cast<ULearningAgentsManager>(Actor->GetComponentByClass(ULearningAgentsManager::StaticClass()));
-		if (Manager)
-		{
-			Manager->AddAgent(this);
-			FoundManager = true;
-		}
-    }
-	if(!FoundManager)
+	if (ArenaIndex != INDEX_NONE)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Could not find Learning Agents manager."));
+		// AMyLearningManager 가 생성한 arena 는 manager, origin 이 이미 정해져 있다
+		FlushManagerTasks(AgentManager);
+		AgentId = AgentManager->AddAgent(this);
+		FoundManager = true;
 	}
-
-	// Origin 찾기
-	TArray<AActor*> Origins;
-	UGameplayStatics::GetAllActorsWithTag(
-		GetWorld(), OriginTag, Origins
-	);
-	float Distance = 10000.0f;
-	AActor* NearestOrigin = 
-	UGameplayStatics::FindNearestActor(GetActorLocation(), Origins, Distance);
-	if (NearestOrigin)
+	else
 	{
-		OriginLocation = NearestOrigin->GetActorLocation();
-		UE_LOG(LogTemp, Warning, TEXT("OriginLocation: %s"), *OriginLocation.ToString());
+		// LearningAgentsManager 찾기
+		TArray<AActor*> Managers;
+		UGameplayStatics::GetAllActorsWithTag(
+			GetWorld(), ManagerTag, Managers
+		);
+		for (AActor* Actor : Managers)
+	    {
+	        ULearningAgentsManager* Manager = 
+			Cast<ULearningAgentsManager>(Actor->GetComponentByClass(ULearningAgentsManager::StaticClass()));
+			if (Manager)
+			{
+				FlushManagerTasks(Manager);
+				AgentId = Manager->AddAgent(this);
+				AgentManager = Manager;
+				FoundManager = true;
+			}
+	    }
+		if(!FoundManager)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not find Learning Agents manager."));
+		}
+
+		// Origin 찾기
+		TArray<AActor*> Origins;
+		UGameplayStatics::GetAllActorsWithTag(
+			GetWorld(), OriginTag, Origins
+		);
+		float Distance = 10000.0f;
+		AActor* NearestOrigin = 
+		UGameplayStatics::FindNearestActor(GetActorLocation(), Origins, Distance);
+		if (NearestOrigin)
+		{
+			OriginLocation = NearestOrigin->GetActorLocation();
+			UE_LOG(LogTemp, Warning, TEXT("OriginLocation: %s"), *OriginLocation.ToString());
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("No nearby origin found within %.2f units"), Distance);
+		}
 	}
-	else
+
+	// manager 가 무기 생성 전에 headless 로 설정했을 수 있다
+	if (bHeadlessMode)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("No nearby origin found within %.2f units"), Distance);
+		SetHeadlessMode(true);
 	}
 
 	InitSimulatePhysics();
 	InitPointHandle();
+	CaptureRestPose();
+	InitKinematicArms();
 
     CalculateMaxRange();
 
-    MakeEnemyInformation();
+	// 생성된 arena 는 상대가 아직 없을 수 있어서 manager 가 둘 다 생성한 뒤 시작한다
+	if (ArenaIndex == INDEX_NONE)
+	{
+		BeginArenaEpisode();
+	}
+}
+
+void ACapStoneCharacter::BeginArenaEpisode()
+{
+	MakeEnemyInformation();
 	if(IsTraining)
 	{
 		RLResetCharacter();
@@ -484,6 +614,14 @@ void ACapStoneCharacter::InitSimulatePhysics()
 {
 	FName Pelvis = TEXT("pelvis");
 	FName ProfileTest = TEXT("Test");
+
+	// KinematicIK 에서는 ragdoll 을 시뮬레이션하지 않는다
+	if (IsKinematicHands())
+	{
+		GetMesh()->SetAllBodiesBelowSimulatePhysics(Pelvis, false, false);
+		return;
+	}
+
 	PhysicalAnim->SetSkeletalMeshComponent(GetMesh());
 	PhysicalAnim->ApplyPhysicalAnimationProfileBelow(Pelvis, ProfileTest, true, false);
 	GetMesh()->SetAllBodiesBelowSimulatePhysics(Pelvis, true, false); 
@@ -505,6 +643,13 @@ void ACapStoneCharacter::InitPointHandle()
 
 	RightPoint->SetWorldLocation(GetMesh()->GetSocketLocation(hand_rSocket));
 	RightPoint->SetWorldRotation(FRotator::ZeroRotator);
+	LeftPoint->SetWorldLocation(GetMesh()->GetSocketLocation(hand_lSocket));
+	LeftPoint->SetWorldRotation(FRotator::ZeroRotator);
+
+	if (IsKinematicHands())
+	{
+		return;
+	}
 
 	RightHandle->GrabComponentAtLocationWithRotation(
 		GetMesh(),
@@ -513,9 +658,6 @@ void ACapStoneCharacter::InitPointHandle()
 		RightPoint->GetComponentRotation()
 	);
 
-	LeftPoint->SetWorldLocation(GetMesh()->GetSocketLocation(hand_lSocket));
-	LeftPoint->SetWorldRotation(FRotator::ZeroRotator);
-
 	LeftHandle->GrabComponentAtLocationWithRotation(
 		GetMesh(),
 		hand_l,
@@ -524,23 +666,234 @@ void ACapStoneCharacter::InitPointHandle()
 	);
 }
 
+void ACapStoneCharacter::CaptureRestPose()
+{
+	USkeletalMeshComponent* MeshComp = GetMesh();
+	const FTransform ActorTransform = GetActorTransform();
+
+	RestPoseBodies.Reset();
+	for (int32 BodyIndex = 0; BodyIndex < MeshComp->Bodies.Num(); ++BodyIndex)
+	{
+		FBodyInstance* Body = MeshComp->Bodies[BodyIndex];
+		if (!Body || !Body->IsInstanceSimulatingPhysics())
+		{
+			continue;
+		}
+
+		FRestPoseBody& RestBody = RestPoseBodies.AddDefaulted_GetRef();
+		RestBody.BodyIndex = BodyIndex;
+		RestBody.RelativeTransform = Body->GetUnrealWorldTransform().GetRelativeTransform(ActorTransform);
+		RestBody.LinearVelocity = ActorTransform.InverseTransformVectorNoScale(Body->GetUnrealWorldVelocity());
+		RestBody.AngularVelocity = ActorTransform.InverseTransformVectorNoScale(Body->GetUnrealWorldAngularVelocityInRadians());
+	}
+
+	RestRightPointLocation = ActorTransform.InverseTransformPosition(RightPoint->GetComponentLocation());
+	RestLeftPointLocation = ActorTransform.InverseTransformPosition(LeftPoint->GetComponentLocation());
+
+	bHasRestPose = RestPoseBodies.Num() > 0;
+}
+
+void ACapStoneCharacter::RestoreRestPose()
+{
+	USkeletalMeshComponent* MeshComp = GetMesh();
+	const FTransform ActorTransform = GetActorTransform();
+
+	for (const FRestPoseBody& RestBody : RestPoseBodies)
+	{
+		FBodyInstance* Body = MeshComp->Bodies.IsValidIndex(RestBody.BodyIndex) ? MeshComp->Bodies[RestBody.BodyIndex] : nullptr;
+		if (!Body)
+		{
+			continue;
+		}
+
+		Body->SetBodyTransform(RestBody.RelativeTransform * ActorTransform, ETeleportType::TeleportPhysics);
+		Body->SetLinearVelocity(ActorTransform.TransformVectorNoScale(RestBody.LinearVelocity), false);
+		Body->SetAngularVelocityInRadians(ActorTransform.TransformVectorNoScale(RestBody.AngularVelocity), false);
+	}
+
+	// InitPointHandle 과 같이 point 회전은 world 기준 0
+	RightPoint->SetWorldLocationAndRotation(ActorTransform.TransformPosition(RestRightPointLocation), FRotator::ZeroRotator);
+	LeftPoint->SetWorldLocationAndRotation(ActorTransform.TransformPosition(RestLeftPointLocation), FRotator::ZeroRotator);
+
+	RightHandle->SetTargetLocationAndRotation(RightPoint->GetComponentLocation(), RightPoint->GetComponentRotation());
+	LeftHandle->SetTargetLocationAndRotation(LeftPoint->GetComponentLocation(), LeftPoint->GetComponentRotation());
+}
+
+void ACapStoneCharacter::InitKinematicArms()
+{
+	if (!IsKinematicHands())
+	{
+		return;
+	}
+
+	const UBoxComponent* RightBox = RightWeapon ? RightWeapon->BoxComponent : nullptr;
+	const UBoxComponent* LeftBox = LeftWeapon ? LeftWeapon->BoxComponent : nullptr;
+
+	const bool bRightValid = RightArm.Init(GetMesh(), upperarm_r, lowerarm_r, hand_r, RightPoint->GetComponentQuat(), RightBox);
+	const bool bLeftValid = LeftArm.Init(GetMesh(), upperarm_l, lowerarm_l, hand_l, LeftPoint->GetComponentQuat(), LeftBox);
+	if (!bRightValid || !bLeftValid)
+	{
+		UE_LOG(LogTemplateCharacter, Warning, TEXT("%s: arm bones not found, kinematic hands are disabled."), *GetName());
+	}
+}
+
+void ACapStoneCharacter::TickKinematicArms()
+{
+	const FTransform& ActorTransform = GetActorTransform();
+	RightArm.Solve(ActorTransform, RightPoint->GetComponentLocation(), RightPoint->GetComponentQuat());
+	LeftArm.Solve(ActorTransform, LeftPoint->GetComponentLocation(), LeftPoint->GetComponentQuat());
+
+	if (!bKinematicWeaponContact || IsDead)
+	{
+		return;
+	}
+
+	UCapStoneCombatSubsystem* CombatSubsystem = GetWorld()->GetSubsystem<UCapStoneCombatSubsystem>();
+	if (!CombatSubsystem)
+	{
+		return;
+	}
+
+	// OnMeshHit 과 같이 (공격자, 피격자) 쌍은 subsystem 이 스텝마다 한 번만 처리한다
+	for (ACapStoneCharacter* Enemy : EnemyCharacters)
+	{
+		if (Enemy && !Enemy->GetIsDead() && (RightArm.TestContact(Enemy) || LeftArm.TestContact(Enemy)))
+		{
+			CombatSubsystem->QueueHit(this, Enemy, Damage);
+		}
+	}
+}
+
+void ACapStoneCharacter::SetHandControl(ECapStoneHandControl InHandControl)
+{
+	if (HandControl == InHandControl)
+	{
+		return;
+	}
+	HandControl = InHandControl;
+
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	RightHandle->ReleaseComponent();
+	LeftHandle->ReleaseComponent();
+	InitSimulatePhysics();
+	InitPointHandle();
+	CaptureRestPose();
+	InitKinematicArms();
+}
+
 // Called every frame
 void ACapStoneCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	RightHandle->SetTargetLocationAndRotation(
-		RightPoint->GetComponentLocation(),
-		RightPoint->GetComponentRotation()
-	);
+	if (bScriptedOpponent)
+	{
+		TickScriptedOpponent();
+	}
 
-	LeftHandle->SetTargetLocationAndRotation(
-		LeftPoint->GetComponentLocation(),
-		LeftPoint->GetComponentRotation()
-	);
+	if (IsKinematicHands())
+	{
+		TickKinematicArms();
+	}
+	else
+	{
+		RightHandle->SetTargetLocationAndRotation(
+			RightPoint->GetComponentLocation(),
+			RightPoint->GetComponentRotation()
+		);
+
+		LeftHandle->SetTargetLocationAndRotation(
+			LeftPoint->GetComponentLocation(),
+			LeftPoint->GetComponentRotation()
+		);
+	}
+
+#if ENABLE_DRAW_DEBUG
+	if (bDrawDebug)
+	{
+		ShowDebugSphere();
+		ShowRightHandAngle();
+	}
+#endif
+}
+
+void ACapStoneCharacter::InitArena(
+	int32 InArenaIndex, int32 InTeamID, const FVector& InOriginLocation, ULearningAgentsManager* InManager)
+{
+	ArenaIndex = InArenaIndex;
+	TeamID = InTeamID;
+	OriginLocation = InOriginLocation;
+	AgentManager = InManager;
+}
+
+void ACapStoneCharacter::SetScriptedOpponent(bool bScripted, float InMoveScale)
+{
+	ScriptedMoveScale = FMath::Clamp(InMoveScale, 0.f, 1.f);
+	if (bScriptedOpponent == bScripted)
+	{
+		return;
+	}
+	bScriptedOpponent = bScripted;
+
+	if (!IsValid(AgentManager))
+	{
+		return;
+	}
+
+	// trainer 에는 환경이 실제로 한 action 만 들어가도록 scripted 인 동안은 agent 가 아니다
+	FlushManagerTasks(AgentManager);
+	if (bScripted && AgentId != INDEX_NONE)
+	{
+		AgentManager->RemoveAgent(AgentId);
+		AgentId = INDEX_NONE;
+	}
+	else if (!bScripted && AgentId == INDEX_NONE)
+	{
+		AgentId = AgentManager->AddAgent(this);
+	}
+}
+
+void ACapStoneCharacter::TickScriptedOpponent()
+{
+	if (IsDead || !Controller || EnemyCharacters.Num() <= 0 || !EnemyCharacters[0])
+	{
+		return;
+	}
+
+	const FVector ToEnemy = EnemyCharacters[0]->GetActorLocation() - GetActorLocation();
+	const FRotator YawRotation(0, ToEnemy.Rotation().Yaw, 0);
+	Controller->SetControlRotation(YawRotation);
+
+	// 붙어 있으면 밀지 않는다
+	if (ToEnemy.Size2D() > ScriptedStopDistance)
+	{
+		AddMovementInput(FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X), ScriptedMoveScale);
+	}
+}
+
+void ACapStoneCharacter::SetHeadlessMode(bool bHeadless)
+{
+	bHeadlessMode = bHeadless;
+	bDrawDebug = !bHeadless;
 
-	ShowDebugSphere();
-    ShowRightHandAngle();
+	// 카메라는 렌더링 외에 쓰이지 않으므로 tick 까지 끈다
+	CameraBoom->SetActive(!bHeadless);
+	CameraBoom->SetComponentTickEnabled(!bHeadless);
+	FollowCamera->SetActive(!bHeadless);
+	FollowCamera->SetComponentTickEnabled(!bHeadless);
+
+	if (RightWeapon)
+	{
+		RightWeapon->SetActorTickEnabled(!bHeadless);
+	}
+	if (LeftWeapon)
+	{
+		LeftWeapon->SetActorTickEnabled(!bHeadless);
+	}
 }
 
 void ACapStoneCharacter::ShowDebugSphere()
@@ -610,68 +963,34 @@ void ACapStoneCharacter::OnMeshHit(UPrimitiveComponent* HitComp, AActor* OtherAc
 		FName HitBone = Hit.BoneName;
         if (HitBone != "hand_r" && HitBone != "hand_l")
         {
-			AActor* HitActor = Hit.GetActor();
-			if(HitActor != nullptr)
+			// 데미지와 hit 상태는 스텝마다 UCapStoneCombatSubsystem 이 한 번에 처리
+			if (UCapStoneCombatSubsystem* CombatSubsystem = GetWorld()->GetSubsystem<UCapStoneCombatSubsystem>())
 			{
-				FVector ShotDirection;
-				AController* OwnerController = nullptr;
-
-				FPointDamageEvent DamageEvent(Damage, Hit, ShotDirection, nullptr);
-				APawn* OwnerPawn = Cast<APawn>(GetOwner());
-				if(OwnerPawn != nullptr)
-				{
-					OwnerController = OwnerPawn->GetController();
-				}
-				HitActor->TakeDamage(Damage, DamageEvent, OwnerController, this);
+				CombatSubsystem->QueueHit(this, Hit.GetActor(), Damage);
 			}
-
-			UE_LOG(LogTemp, Warning, TEXT("=== OnMeshHit Called ==="));
-			// UE_LOG(LogTemp, Warning, TEXT("HitComp: %s"), *HitComp->GetName());
-			// UE_LOG(LogTemp, Warning, TEXT("OtherActor: %s"), *OtherActor->GetName());
-			// UE_LOG(LogTemp, Warning, TEXT("Hit BoneName: %s"), *Hit.BoneName.ToString());
-			// UE_LOG(LogTemp, Warning, TEXT("Hit Actor: %s"), *GetNameSafe(Hit.GetActor()));
-			// UE_LOG(LogTemp, Warning, TEXT("Hit !!!!!"));
-			// UE_LOG(LogTemp, Warning, TEXT("BoneName: %s"), *GetMesh()->FindClosestBone(Hit.ImpactPoint).ToString());
-			
-			/*
-			UE_LOG(LogTemp, Warning, TEXT("OtherComp: %s"), *OtherComp->GetName());
-			UE_LOG(LogTemp, Warning, TEXT("NormalImpulse: %s"), *NormalImpulse.ToString());
-			UE_LOG(LogTemp, Warning, TEXT("Hit Location: %s"), *Hit.ImpactPoint.ToString());
-			UE_LOG(LogTemp, Warning, TEXT("Hit Component: %s"), *GetNameSafe(Hit.GetComponent()));
-			UE_LOG(LogTemp, Warning, TEXT("Hit Actor: %s"), *GetNameSafe(Hit.GetActor()));
-			*/
-
-			bIsHit = true;
-			GetWorld()->GetTimerManager().ClearTimer(HitResetTimerHandle);
-			GetWorld()->GetTimerManager().SetTimer(
-				HitResetTimerHandle, 
-				this, 
-				&ACapStoneCharacter::ResetHitState, 
-				HitDuration, 
-				false
-			);
-
 		}
     }
 }
 
-void ACapStoneCharacter::ResetHitState()
+float ACapStoneCharacter::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
 {
-    bIsHit = false;
+	float DamageToApplied = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	return ApplyCombatDamage(DamageToApplied);
 }
 
-float ACapStoneCharacter::TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
+float ACapStoneCharacter::ApplyCombatDamage(float DamageAmount)
 {
-	float DamageToApplied = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
-	DamageToApplied = FMath::Min(Health, DamageToApplied);
-	Health = Health - DamageToApplied;
+	if (IsDead)
+	{
+		return 0.f;
+	}
 
-	UE_LOG(LogTemp, Warning, TEXT("Health : %f"), Health);
+	float DamageToApplied = FMath::Min(Health, DamageAmount);
+	Health = Health - DamageToApplied;
 
 	if(Health<=0)
 	{
 		IsDead = true;
-		UE_LOG(LogTemp, Warning, TEXT("Dead"));
 
 		if(!IsTraining){
 			GetMesh()->SetSimulatePhysics(true);
@@ -689,6 +1008,15 @@ float ACapStoneCharacter::TakeDamage(float DamageAmount, struct FDamageEvent con
 
 void ACapStoneCharacter::RLResetCharacter()
 {
+	// curriculum stage 는 episode 사이에서만 바뀐다
+	if (bHasPendingArenaLimits)
+	{
+		ResetDistance = PendingResetDistance;
+		MaxRadius = PendingMaxRadius;
+		MaxEnemyDistance = PendingMaxEnemyDistance;
+		bHasPendingArenaLimits = false;
+	}
+
 	if(EnemyCharacters.Num() <= 0)
 	{
 		return;
@@ -698,10 +1026,14 @@ void ACapStoneCharacter::RLResetCharacter()
 		return;
 	}
 	
-	GetMesh()->SetSimulatePhysics(false);
+	// rest pose 가 있으면 physics 를 끄지 않고 teleport 후 그 상태로 되돌린다
+	if (!bHasRestPose)
+	{
+		GetMesh()->SetSimulatePhysics(false);
+	}
 
-	float RandomRadian = FMath::FRandRange(0.f, 6.28f);
-	float RandomDistance = FMath::FRandRange(0.5f, 1.f) * ResetDistance;
+	float RandomRadian = ResetRandom.FRandRange(0.f, 6.28f);
+	float RandomDistance = ResetRandom.FRandRange(0.5f, 1.f) * ResetDistance;
 
 	float ResetLocationX = 
 	EnemyLocation[0].X + FMath::Cos(RandomRadian) * RandomDistance;
@@ -742,8 +1074,17 @@ void ACapStoneCharacter::RLResetCharacter()
 	EnemyCharacters[0]->SetHealth(100.0);
 	Stamina = 0;
 
+	GetCharacterMovement()->StopMovementImmediately();
+
+	if (bHasRestPose)
+	{
+		RestoreRestPose();
+		return;
+	}
+
 	InitSimulatePhysics();
 	InitPointHandle();
+	InitKinematicArms();
 }
 
 //////////////////////////////////////////////////////////////////////////
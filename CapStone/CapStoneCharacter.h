@@ -8,6 +8,7 @@
 #include "PhysicsEngine/PhysicsHandleComponent.h"
 #include "PhysicsEngine/PhysicalAnimationComponent.h"
 #include "PhysicsEngine/ConstraintInstance.h"
+#include "CapStoneKinematicArm.h"
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
@@ -18,10 +19,21 @@ class USpringArmComponent;
 class UCameraComponent;
 class UInputMappingContext;
 class UInputAction;
+class ULearningAgentsManager;
 struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
+/** How RightPoint / LeftPoint drive the hands */
+UENUM(BlueprintType)
+enum class ECapStoneHandControl : uint8
+{
+	/** Ragdoll below the pelvis, hands pulled by physics handles */
+	PhysicsHandle,
+	/** No ragdoll simulation. Analytic two-bone IK and kinematic weapon contact. */
+	KinematicIK,
+};
+
 UCLASS(config=Game)
 class ACapStoneCharacter : public ACharacter
 {
@@ -75,13 +87,10 @@ class ACapStoneCharacter : public ACharacter
 
 	UBoxComponent* WeaponCollider;
 
+	// UCapStoneCombatSubsystem 이 스텝 수로 만료시킨다
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	bool bIsHit = false;
 
-	float HitDuration = 0.2f;	
-
-	FTimerHandle HitResetTimerHandle;
-
 public:
 	ACapStoneCharacter();
 
@@ -92,6 +101,20 @@ public:
 
     void ShowRightHandAngle();
 
+	/** AMyLearningManager 가 arena 를 생성할 때 FinishSpawning 전에 호출한다 */
+	void InitArena(int32 InArenaIndex, int32 InTeamID, const FVector& InOriginLocation, ULearningAgentsManager* InManager);
+
+	/** Reset 위치에 쓰는 random stream. AMyLearningManager 가 run seed 와 arena index 로 정한다 */
+	void SetRandomSeed(int32 Seed) { ResetRandom.Initialize(Seed); }
+
+	/** Headless 학습용: debug drawing 과 카메라를 끈다 */
+	void SetHeadlessMode(bool bHeadless);
+
+	/** Switches the hand backend. After BeginPlay this re-initializes the physics state and the hand points. */
+	void SetHandControl(ECapStoneHandControl InHandControl);
+
+	ECapStoneHandControl GetHandControl() const { return HandControl; }
+
     UFUNCTION(BlueprintCallable)	
 	void RLMove(FVector2D MovementVector);
 	UFUNCTION(BlueprintCallable)	
@@ -102,8 +125,27 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void RLLeftPointMove(FVector LeftOffset);
 
+	/**
+	 * 한 스텝의 손 action 을 한 번에 적용한다. 축마다 -1, 0, 1.
+	 * 이동은 X, Y, Z 순서로 RLRightPointMove 와 같이 reach 검사 후 더하고, 회전은 그 뒤에 local 로 더한다.
+	 * neck socket 은 한 번만 읽고 point 마다 transform 갱신은 한 번이다.
+	 */
+	void RLApplyHandSteps(
+		const FIntVector& RightMove, const FIntVector& RightRotate,
+		const FIntVector& LeftMove, const FIntVector& LeftRotate,
+		float LocationAmount, float RotationAmount);
+
 	void RLResetCharacter();
 
+	/** UCapStoneEnemySubsystem 에서 가장 가까운 적 정보를 다시 가져온다 */
+	void MakeEnemyInformation();
+
+	/**
+	 * 적 정보를 채우고 학습 중이면 첫 episode 를 리셋으로 시작한다.
+	 * 배치된 캐릭터는 BeginPlay 에서, 생성된 arena 의 캐릭터는 상대가 생긴 뒤 AMyLearningManager 가 호출한다.
+	 */
+	void BeginArenaEpisode();
+
 	// Getter, Setter
 	const TArray<FVector>& GetEnemyLocation() const;
 	const TArray<FVector>& GetEnemyDirection() const;
@@ -126,15 +168,42 @@ public:
 	float GetHealth() const { return Health; }
 	void SetHealth(float NewHealth) { Health = FMath::Clamp(NewHealth, 0.f, 100.f); }
 
+	/** Damage path used by UCapStoneCombatSubsystem, without the AActor::TakeDamage chain. Returns the damage applied. */
+	float ApplyCombatDamage(float DamageAmount);
+
 	float GetMaxEnemyDistance() const { return MaxEnemyDistance; }
 
+	/**
+	 * FCapStoneCurriculum 이 stage 를 바꿀 때 호출한다.
+	 * 진행 중인 episode 의 termination 거리가 바뀌지 않도록 다음 RLResetCharacter 에서 한꺼번에 적용된다.
+	 */
+	void SetPendingArenaLimits(float InResetDistance, float InMaxRadius, float InMaxEnemyDistance)
+	{
+		PendingResetDistance = InResetDistance;
+		PendingMaxRadius = InMaxRadius;
+		PendingMaxEnemyDistance = InMaxEnemyDistance;
+		bHasPendingArenaLimits = true;
+	}
+
+	/**
+	 * FCapStoneCurriculum 이 easy stage 의 opponent 를 학습에서 뺄 때 호출한다. RunTraining, ProcessExperience 밖의 game thread 에서만.
+	 * Scripted 인 동안은 LearningAgentsManager 에서 빠지고 Tick 에서 hand action 없이 적에게 InMoveScale 속도로 걸어간다.
+	 */
+	void SetScriptedOpponent(bool bScripted, float InMoveScale);
+
+	bool IsScriptedOpponent() const { return bScriptedOpponent; }
+
+	int32 GetTeamID() const { return TeamID; }
+	int32 GetArenaIndex() const { return ArenaIndex; }
+
+	int32 GetAgentId() const { return AgentId; }
+	const ULearningAgentsManager* GetAgentManager() const { return AgentManager; }
+
 	float GetEHRScale() const { return EnemyHealthRewardScale; }
 	float GetMHRScale() const { return MyHealthRewardScale; }
 	float GetSRScale() const { return StaminaRewardScale; }
 
 protected:
-	void ResetHitState();
-
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
 
@@ -155,8 +224,12 @@ protected:
 	);
 
 protected:
+    virtual void PostInitializeComponents() override;
+
     virtual void BeginPlay() override;
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     void CalculateMaxRange();
 
     void NewFunction();
@@ -175,14 +248,43 @@ public:
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
+	/** KinematicIK 결과, world 기준. AnimBP 의 two-bone IK 노드가 읽는다 */
+	UFUNCTION(BlueprintPure, Category = "HandControl")
+	FTransform GetRightHandIKTransform() const { return RightArm.HandTransform; }
+	UFUNCTION(BlueprintPure, Category = "HandControl")
+	FVector GetRightElbowIKLocation() const { return RightArm.ElbowLocation; }
+	UFUNCTION(BlueprintPure, Category = "HandControl")
+	FTransform GetLeftHandIKTransform() const { return LeftArm.HandTransform; }
+	UFUNCTION(BlueprintPure, Category = "HandControl")
+	FVector GetLeftElbowIKLocation() const { return LeftArm.ElbowLocation; }
+
 private:
 	TArray<ACapStoneCharacter*> EnemyCharacters;
 	TArray<FVector> EnemyLocation;
 	TArray<FVector> EnemyDirection;
 
-	void MakeEnemyInformation();
 	void InitPointHandle();
 
+	/** InitSimulatePhysics, InitPointHandle 직후의 ragdoll 상태를 actor 기준으로 저장한다 */
+	void CaptureRestPose();
+
+	/** 저장된 rest pose 로 body 와 hand point 를 되돌린다. Physics 설정과 handle grab 은 그대로 둔다 */
+	void RestoreRestPose();
+
+	struct FRestPoseBody
+	{
+		int32 BodyIndex;
+		// actor 기준 transform, velocity
+		FTransform RelativeTransform;
+		FVector LinearVelocity;
+		FVector AngularVelocity;
+	};
+
+	TArray<FRestPoseBody> RestPoseBodies;
+	FVector RestRightPointLocation = FVector::ZeroVector;
+	FVector RestLeftPointLocation = FVector::ZeroVector;
+	bool bHasRestPose = false;
+
 	FName hand_rSocket = TEXT("hand_rSocket");
 	FName hand_r = TEXT("hand_r");
 	FName lowerarm_r = TEXT("lowerarm_r");
@@ -191,6 +293,30 @@ private:
 	FName hand_l = TEXT("hand_l");
 	FName lowerarm_l = TEXT("lowerarm_l");
 
+	FName upperarm_r = TEXT("upperarm_r");
+	FName upperarm_l = TEXT("upperarm_l");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "HandControl")
+	ECapStoneHandControl HandControl = ECapStoneHandControl::PhysicsHandle;
+
+	/** KinematicIK 에서 physics 대신 무기와 상대 capsule 의 거리로 hit 을 만든다 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "HandControl")
+	bool bKinematicWeaponContact = true;
+
+	FCapStoneKinematicArm RightArm;
+	FCapStoneKinematicArm LeftArm;
+
+	/** 현재 자세에서 두 팔의 IK 를 초기화한다 */
+	void InitKinematicArms();
+
+	/** Hand point 로 IK 를 풀고 무기 접촉을 combat subsystem 에 넘긴다 */
+	void TickKinematicArms();
+
+	/** 적을 바라보고 가까워질 때까지 ScriptedMoveScale 로 걸어간다 */
+	void TickScriptedOpponent();
+
+	bool IsKinematicHands() const { return HandControl == ECapStoneHandControl::KinematicIK; }
+
 	FRotator RightRotator = FRotator::ZeroRotator;
 	FRotator LeftRotator = FRotator::ZeroRotator;
 
@@ -203,6 +329,20 @@ private:
 	float MaxRadius = 400.f;
 	float MaxEnemyDistance = 600.f;
 
+	// curriculum 의 easy stage 에서 policy 대신 적에게 걸어가기만 하는 opponent
+	bool bScriptedOpponent = false;
+	float ScriptedMoveScale = 1.f;
+	static constexpr float ScriptedStopDistance = 100.f;
+
+	// 다음 리셋에서 적용할 curriculum stage 값
+	bool bHasPendingArenaLimits = false;
+	float PendingResetDistance = 0.f;
+	float PendingMaxRadius = 0.f;
+	float PendingMaxEnemyDistance = 0.f;
+
+	// 전역 FMath::FRand 대신 캐릭터마다 가진다. 같은 seed 면 같은 reset 순서가 나온다
+	FRandomStream ResetRandom;
+
 	float EnemyHealthRewardScale = 1.0f; 
 	float MyHealthRewardScale = 1.0f;
 	float StaminaRewardScale = 1.0f;
@@ -212,9 +352,13 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = ManagerTag)
 	FName ManagerTag;
 	bool FoundManager = false;
+	ULearningAgentsManager* AgentManager = nullptr;
+	int32 AgentId = INDEX_NONE;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = OriginTag)
 	FName OriginTag;
 	FVector OriginLocation = FVector::ZeroVector;
+	// 레벨에 직접 배치된 캐릭터는 INDEX_NONE
+	int32 ArenaIndex = INDEX_NONE;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
 	bool IsTraining = true;
@@ -234,5 +378,15 @@ private:
 
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
 	TSubclassOf<class AWeapon> HandLeft;
+
+	UPROPERTY()
+	AWeapon* RightWeapon = nullptr;
+	UPROPERTY()
+	AWeapon* LeftWeapon = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = Debug)
+	bool bDrawDebug = true;
+
+	bool bHeadlessMode = false;
 };
 
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneCombatSubsystem.h"
+
+#include "CapStoneCharacter.h"
+
+void UCapStoneCombatSubsystem::QueueHit(ACapStoneCharacter* Attacker, AActor* Victim, float Damage)
+{
+	// 접촉 중에는 같은 쌍의 notification 이 계속 들어오므로 스텝마다 한 번만 남긴다
+	for (const FHitEvent& Event : PendingHits)
+	{
+		if (Event.Attacker == Attacker && Event.Victim == Victim)
+		{
+			return;
+		}
+	}
+	PendingHits.Add({ Attacker, Victim, Damage });
+}
+
+void UCapStoneCombatSubsystem::UnregisterCharacter(ACapStoneCharacter* Character)
+{
+	HitStepsLeft.Remove(Character);
+	PendingHits.RemoveAllSwap([Character](const FHitEvent& Event)
+	{
+		return Event.Attacker == Character || Event.Victim == Character;
+	});
+}
+
+bool UCapStoneCombatSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCapStoneCombatSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ResolveHits();
+}
+
+TStatId UCapStoneCombatSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCapStoneCombatSubsystem, STATGROUP_Tickables);
+}
+
+void UCapStoneCombatSubsystem::ResolveHits()
+{
+	// 여러 manager 가 같은 프레임에 호출해도 한 번만 처리
+	if (LastResolveFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastResolveFrame = GFrameCounter;
+
+	for (auto It = HitStepsLeft.CreateIterator(); It; ++It)
+	{
+		if (--It.Value() <= 0)
+		{
+			It.Key()->SetIsHit(false);
+			It.RemoveCurrent();
+		}
+	}
+
+	for (const FHitEvent& Event : PendingHits)
+	{
+		if (ACapStoneCharacter* Victim = Cast<ACapStoneCharacter>(Event.Victim))
+		{
+			Victim->ApplyCombatDamage(Event.Damage);
+		}
+
+		Event.Attacker->SetIsHit(true);
+		HitStepsLeft.Add(Event.Attacker, HitDurationSteps);
+	}
+	PendingHits.Reset();
+}
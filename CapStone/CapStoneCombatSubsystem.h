@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CapStoneCombatSubsystem.generated.h"
+
+class ACapStoneCharacter;
+
+/**
+ * 무기 hit notification 을 스텝 단위 queue 에 모았다가 ResolveHits() 에서 한 번에 처리한다.
+ * 같은 스텝에 같은 (공격자, 피격자) 쌍은 한 번만 데미지를 준다.
+ * 공격자의 hit 상태는 timer 대신 스텝 수로 만료된다.
+ * AMyLearningManager 가 스텝 시작에 직접 호출하고, manager 가 없는 월드에서는 자체 Tick 에서 처리한다.
+ */
+UCLASS()
+class CAPSTONE_API UCapStoneCombatSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Called from the weapon hit callback. Only records the event. */
+	void QueueHit(ACapStoneCharacter* Attacker, AActor* Victim, float Damage);
+
+	/** Applies queued damage, sets hit flags and expires old ones. Runs at most once per frame. */
+	void ResolveHits();
+
+	void UnregisterCharacter(ACapStoneCharacter* Character);
+
+	void SetHitDurationSteps(int32 InHitDurationSteps) { HitDurationSteps = FMath::Max(InHitDurationSteps, 1); }
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FHitEvent
+	{
+		ACapStoneCharacter* Attacker;
+		AActor* Victim;
+		float Damage;
+	};
+
+	TArray<FHitEvent> PendingHits;
+
+	// hit 상태인 공격자와 남은 스텝 수
+	TMap<ACapStoneCharacter*, int32> HitStepsLeft;
+
+	/** 0.2 s at 30 steps per second */
+	int32 HitDurationSteps = 6;
+
+	uint64 LastResolveFrame = MAX_uint64;
+};
@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneCurriculum.h"
+
+#include "CapStoneAgentSnapshot.h"
+#include "CapStoneCharacter.h"
+
+TArray<FCapStoneCurriculumStage> FCapStoneCurriculum::MakeDefaultStages()
+{
+	TArray<FCapStoneCurriculumStage> Stages;
+
+	// 가까이서 느리게 다가오는 scripted 상대 -> 절반 속도 scripted 상대 -> 학습하는 상대
+	FCapStoneCurriculumStage& Near = Stages.AddDefaulted_GetRef();
+	Near.ResetDistance = 200.f;
+	Near.MaxRadius = 250.f;
+	Near.MaxEnemyDistance = 400.f;
+	Near.bScriptedOpponent = true;
+	Near.ScriptedOpponentSpeed = 0.25f;
+
+	FCapStoneCurriculumStage& Mid = Stages.AddDefaulted_GetRef();
+	Mid.ResetDistance = 400.f;
+	Mid.MaxRadius = 300.f;
+	Mid.MaxEnemyDistance = 500.f;
+	Mid.bScriptedOpponent = true;
+	Mid.ScriptedOpponentSpeed = 0.5f;
+	Mid.DemoteSuccessRate = 0.1f;
+
+	FCapStoneCurriculumStage& Full = Stages.AddDefaulted_GetRef();
+	Full.DemoteSuccessRate = 0.1f;
+
+	return Stages;
+}
+
+void FCapStoneCurriculum::Init(const TArray<ACapStoneCharacter*>& Characters, const FCapStoneCurriculumSettings& InSettings)
+{
+	Settings = InSettings;
+	if (Settings.Stages.Num() == 0)
+	{
+		Settings.Stages = MakeDefaultStages();
+	}
+	Settings.WindowEpisodeNum = FMath::Max(Settings.WindowEpisodeNum, 1);
+
+	Arenas.Reset();
+	Episodes.Reset();
+	PendingOpponents.Reset();
+
+	for (ACapStoneCharacter* Character : Characters)
+	{
+		if (Character)
+		{
+			Arenas.FindOrAdd(Character->GetArenaIndex()).Characters.Add(Character);
+		}
+	}
+
+	for (TPair<int32, FArenaState>& Pair : Arenas)
+	{
+		ApplyStage(Pair.Value);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Curriculum: %d stages over %d arenas, re-evaluated every %d episodes."),
+		Settings.Stages.Num(), Arenas.Num(), Settings.WindowEpisodeNum);
+}
+
+void FCapStoneCurriculum::RecordStep(const FCapStoneAgentSnapshot& Snapshot, TConstArrayView<int32> AgentIds)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	Episodes.SetNum(Snapshot.GetMaxAgentNum());
+
+	for (const int32 AgentId : AgentIds)
+	{
+		if (!Snapshot.IsValid(AgentId) || !Episodes.IsValidIndex(AgentId))
+		{
+			continue;
+		}
+
+		FAgentEpisode& Episode = Episodes[AgentId];
+		Episode.StepNum++;
+		Episode.bSuccess |= Snapshot.Hit[AgentId];
+		if (Snapshot.EnemyNum[AgentId] > 0)
+		{
+			Episode.bSuccess |= Snapshot.EnemyDead[FCapStoneAgentSnapshot::EnemyIndex(AgentId, 0)];
+		}
+	}
+}
+
+void FCapStoneCurriculum::EndEpisode(ACapStoneCharacter* Character)
+{
+	if (!IsEnabled() || !Character)
+	{
+		return;
+	}
+
+	const int32 AgentId = Character->GetAgentId();
+	if (!Episodes.IsValidIndex(AgentId))
+	{
+		return;
+	}
+
+	const FAgentEpisode Episode = Episodes[AgentId];
+	Episodes[AgentId] = FAgentEpisode();
+
+	// opponent 의 episode 는 stage 판단에 쓰지 않는다
+	FArenaState* Arena = Arenas.Find(Character->GetArenaIndex());
+	if (!Arena || Character->GetTeamID() != 0 || Episode.StepNum == 0)
+	{
+		return;
+	}
+
+	Arena->EpisodeNum++;
+	Arena->SuccessNum += Episode.bSuccess;
+	Arena->StepNum += Episode.StepNum;
+
+	if (Arena->EpisodeNum < Settings.WindowEpisodeNum)
+	{
+		return;
+	}
+
+	const float SuccessRate = (float)Arena->SuccessNum / Arena->EpisodeNum;
+	const float MeanSteps = (float)Arena->StepNum / Arena->EpisodeNum;
+	const FCapStoneCurriculumStage& Stage = Settings.Stages[Arena->Stage];
+	const bool bLongEnough = MeanSteps >= Settings.MinMeanEpisodeSteps;
+
+	const int32 PrevStage = Arena->Stage;
+	if (SuccessRate >= Stage.PromoteSuccessRate && bLongEnough)
+	{
+		Arena->Stage = FMath::Min(Arena->Stage + 1, Settings.Stages.Num() - 1);
+	}
+	else if (SuccessRate < Stage.DemoteSuccessRate || !bLongEnough)
+	{
+		Arena->Stage = FMath::Max(Arena->Stage - 1, 0);
+	}
+
+	if (Arena->Stage != PrevStage)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Curriculum: arena %d stage %d -> %d (success %.2f, mean %.1f steps)."),
+			Character->GetArenaIndex(), PrevStage, Arena->Stage, SuccessRate, MeanSteps);
+		ApplyStage(*Arena);
+	}
+
+	Arena->EpisodeNum = 0;
+	Arena->SuccessNum = 0;
+	Arena->StepNum = 0;
+}
+
+void FCapStoneCurriculum::ApplyOpponentRoles()
+{
+	for (ACapStoneCharacter* Character : PendingOpponents)
+	{
+		const FArenaState* Arena = Arenas.Find(Character->GetArenaIndex());
+		if (!Arena)
+		{
+			continue;
+		}
+
+		// 빠지는 AgentId 가 다시 쓰일 때 지난 episode 가 섞이지 않게 한다
+		if (Episodes.IsValidIndex(Character->GetAgentId()))
+		{
+			Episodes[Character->GetAgentId()] = FAgentEpisode();
+		}
+
+		const FCapStoneCurriculumStage& Stage = Settings.Stages[Arena->Stage];
+		Character->SetScriptedOpponent(Stage.bScriptedOpponent, Stage.ScriptedOpponentSpeed);
+	}
+	PendingOpponents.Reset();
+}
+
+int32 FCapStoneCurriculum::GetStage(int32 ArenaIndex) const
+{
+	const FArenaState* Arena = Arenas.Find(ArenaIndex);
+	return Arena ? Arena->Stage : INDEX_NONE;
+}
+
+void FCapStoneCurriculum::ApplyStage(FArenaState& Arena)
+{
+	const FCapStoneCurriculumStage& Stage = Settings.Stages[Arena.Stage];
+
+	for (ACapStoneCharacter* Character : Arena.Characters)
+	{
+		Character->SetPendingArenaLimits(Stage.ResetDistance, Stage.MaxRadius, Stage.MaxEnemyDistance);
+
+		// EndEpisode 는 RunTraining 안에서 불리므로 agent 등록은 여기서 바꾸지 않는다
+		if (Character->GetTeamID() != 0)
+		{
+			PendingOpponents.AddUnique(Character);
+		}
+	}
+}
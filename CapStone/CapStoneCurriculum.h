@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CapStoneCurriculum.generated.h"
+
+class ACapStoneCharacter;
+struct FCapStoneAgentSnapshot;
+
+/** Arena difficulty for one curriculum stage */
+USTRUCT(BlueprintType)
+struct CAPSTONE_API FCapStoneCurriculumStage
+{
+	GENERATED_BODY()
+
+	/** ACapStoneCharacter::ResetDistance, how far from the enemy an episode starts */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float ResetDistance = 800.f;
+
+	/** ACapStoneCharacter::MaxRadius, reset locations stay this close to the arena origin */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float MaxRadius = 400.f;
+
+	/** ACapStoneCharacter::MaxEnemyDistance, the episode terminates beyond it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float MaxEnemyDistance = 600.f;
+
+	/**
+	 * Makes the opponent (team 1) a scripted character instead of a learning agent.
+	 * It leaves the LearningAgentsManager and walks toward the agent with no hand actions, so the trainer never sees an action
+	 * the environment did not take.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bScriptedOpponent = false;
+
+	/** Fraction of the walk speed the scripted opponent moves at */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1", EditCondition = "bScriptedOpponent"))
+	float ScriptedOpponentSpeed = 0.5f;
+
+	/** Move to the next stage at or above this success rate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1"))
+	float PromoteSuccessRate = 0.6f;
+
+	/** Move back to the previous stage below this success rate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", ClampMax = "1"))
+	float DemoteSuccessRate = 0.f;
+};
+
+USTRUCT(BlueprintType)
+struct CAPSTONE_API FCapStoneCurriculumSettings
+{
+	GENERATED_BODY()
+
+	/** Easiest first. Empty uses FCapStoneCurriculum::MakeDefaultStages. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FCapStoneCurriculumStage> Stages;
+
+	/** Agent episodes an arena plays before its stage is re-evaluated */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 WindowEpisodeNum = 32;
+
+	/** Episodes shorter than this on average count as failed windows even at a good success rate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0"))
+	float MinMeanEpisodeSteps = 0.f;
+};
+
+/**
+ * Arena 별 curriculum.
+ * Agent (team 0) 의 episode 가 끝날 때마다 성공 여부와 길이를 모으고 WindowEpisodeNum 개가 차면 stage 를 올리거나 내린다.
+ * 성공은 episode 중에 한 번이라도 적을 때렸거나 적이 죽은 경우다.
+ * Stage 가 바뀌면 거리는 그 arena 의 캐릭터마다 다음 reset 에서 적용된다. 진행 중인 episode 의 거리는 바뀌지 않는다.
+ * Opponent 의 scripted, learning 전환은 LearningAgentsManager 를 바꾸므로 ApplyOpponentRoles 에서 스텝이 끝난 뒤에 한다.
+ */
+struct CAPSTONE_API FCapStoneCurriculum
+{
+	static TArray<FCapStoneCurriculumStage> MakeDefaultStages();
+
+	/** Groups Characters by arena. The first stage applies from each character's next reset. */
+	void Init(const TArray<ACapStoneCharacter*>& Characters, const FCapStoneCurriculumSettings& InSettings);
+
+	bool IsEnabled() const { return Settings.Stages.Num() > 0; }
+
+	/** Accumulates episode length and contact for AgentIds. Called from GatherAgentCompletions on the game thread. */
+	void RecordStep(const FCapStoneAgentSnapshot& Snapshot, TConstArrayView<int32> AgentIds);
+
+	/** Game thread, before Character is reset: closes its episode and moves its arena between stages */
+	void EndEpisode(ACapStoneCharacter* Character);
+
+	/** Game thread, outside RunTraining and ProcessExperience: moves opponents whose stage changed between scripted and learning */
+	void ApplyOpponentRoles();
+
+	int32 GetStage(int32 ArenaIndex) const;
+
+private:
+	struct FArenaState
+	{
+		TArray<ACapStoneCharacter*> Characters;
+		int32 Stage = 0;
+		int32 EpisodeNum = 0;
+		int32 SuccessNum = 0;
+		int64 StepNum = 0;
+	};
+
+	struct FAgentEpisode
+	{
+		int32 StepNum = 0;
+		bool bSuccess = false;
+	};
+
+	void ApplyStage(FArenaState& Arena);
+
+	FCapStoneCurriculumSettings Settings;
+
+	// 배치된 캐릭터는 모두 INDEX_NONE arena 하나로 묶인다
+	TMap<int32, FArenaState> Arenas;
+
+	// AgentId 로 index
+	TArray<FAgentEpisode> Episodes;
+
+	// stage 가 바뀌어 ApplyOpponentRoles 를 기다리는 opponent
+	TArray<ACapStoneCharacter*> PendingOpponents;
+};
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneDecisionLOD.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
+#include "CapStoneAgentSnapshot.h"
+#include "CapStoneCharacter.h"
+
+void FCapStoneDecisionLOD::Update(const UWorld* World, const FCapStoneAgentSnapshot& Snapshot, const FCapStoneDecisionLODSettings& Settings)
+{
+	const int32 MaxAgentNum = Snapshot.GetMaxAgentNum();
+	DecisionMask.Init(false, MaxAgentNum);
+	DecisionAgentIds.Reset();
+	Intervals.SetNum(MaxAgentNum);
+
+	ViewLocations.Reset();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->PlayerCameraManager)
+		{
+			ViewLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+	}
+
+	const float NearDistanceSquared = FMath::Square(Settings.NearDistance);
+	const float MidDistanceSquared = FMath::Square(Settings.MidDistance);
+
+	for (int32 AgentId = 0; AgentId < MaxAgentNum; ++AgentId)
+	{
+		if (!Snapshot.IsValid(AgentId))
+		{
+			Intervals[AgentId] = 1;
+			continue;
+		}
+
+		int32 Interval = 1;
+		if (Snapshot.Dead[AgentId])
+		{
+			Interval = Settings.DeadInterval;
+		}
+		else if (ViewLocations.Num() > 0)
+		{
+			float DistanceSquared = MAX_flt;
+			for (const FVector& ViewLocation : ViewLocations)
+			{
+				DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(ViewLocation, Snapshot.Location[AgentId]));
+			}
+
+			if (DistanceSquared > MidDistanceSquared)
+			{
+				Interval = Settings.FarInterval;
+			}
+			else if (DistanceSquared > NearDistanceSquared)
+			{
+				Interval = Settings.MidInterval;
+			}
+
+			// 가까워도 화면에 안 보이면 offscreen interval 까지 늘린다
+			if (!Snapshot.Characters[AgentId]->WasRecentlyRendered(0.2f))
+			{
+				Interval = FMath::Max(Interval, Settings.OffscreenInterval);
+			}
+		}
+
+		Interval = FMath::Max(Interval, 1);
+		Intervals[AgentId] = Interval;
+		if ((Frame + AgentId) % Interval == 0)
+		{
+			DecisionMask[AgentId] = true;
+			DecisionAgentIds.Add(AgentId);
+		}
+	}
+
+	++Frame;
+}
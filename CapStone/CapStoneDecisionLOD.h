@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CapStoneDecisionLOD.generated.h"
+
+struct FCapStoneAgentSnapshot;
+
+/** Decision intervals in frames. 1 decides every frame. */
+USTRUCT(BlueprintType)
+struct CAPSTONE_API FCapStoneDecisionLODSettings
+{
+	GENERATED_BODY()
+
+	/** Agents closer than this to any viewer decide every frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float NearDistance = 1500.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MidDistance = 4000.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 MidInterval = 2;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 FarInterval = 4;
+
+	/** Not rendered recently, whatever the distance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 OffscreenInterval = 8;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+	int32 DeadInterval = 30;
+};
+
+/**
+ * Inference 모드에서 agent 마다 몇 프레임에 한 번 새 action 을 받을지 정한다.
+ * 거리, 화면에 보였는지, 죽었는지로 interval 을 고르고 (Frame + AgentId) % Interval 로 프레임을 분산한다.
+ * 결정하는 agent 만 observation 을 모으고 평가하며, 결정하지 않는 프레임에는 interactor 가 마지막 이동, 회전만 유지한다.
+ */
+struct CAPSTONE_API FCapStoneDecisionLOD
+{
+	/** Rebuilds the mask for this frame. Without a viewer (headless) only the dead rule applies. */
+	void Update(const UWorld* World, const FCapStoneAgentSnapshot& Snapshot, const FCapStoneDecisionLODSettings& Settings);
+
+	int32 GetInterval(int32 AgentId) const { return Intervals.IsValidIndex(AgentId) ? Intervals[AgentId] : 1; }
+
+	const TBitArray<>& GetDecisionMask() const { return DecisionMask; }
+
+	/** Agents due this frame in ascending order, the same set as GetDecisionMask */
+	const TArray<int32>& GetDecisionAgentIds() const { return DecisionAgentIds; }
+
+private:
+	TBitArray<> DecisionMask;
+	TArray<int32> DecisionAgentIds;
+	TArray<int32> Intervals;
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	uint64 Frame = 0;
+};
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneEnemySubsystem.h"
+
+#include "CapStoneCharacter.h"
+
+void UCapStoneEnemySubsystem::RegisterCharacter(ACapStoneCharacter* Character)
+{
+	if (Character)
+	{
+		Characters.AddUnique(Character);
+		bGridDirty = true;
+	}
+}
+
+void UCapStoneEnemySubsystem::UnregisterCharacter(ACapStoneCharacter* Character)
+{
+	if (Characters.RemoveSingleSwap(Character) > 0)
+	{
+		bGridDirty = true;
+	}
+}
+
+bool UCapStoneEnemySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FIntPoint UCapStoneEnemySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt32(Location.X / CellSize),
+		FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+void UCapStoneEnemySubsystem::RefreshEnemyInformation(bool bForce)
+{
+	// 여러 manager 가 같은 프레임에 호출해도 한 번만 갱신
+	if (!bForce && LastRefreshFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastRefreshFrame = GFrameCounter;
+
+	RebuildGrid();
+
+	for (ACapStoneCharacter* Character : Characters)
+	{
+		Character->MakeEnemyInformation();
+	}
+}
+
+void UCapStoneEnemySubsystem::RebuildGrid()
+{
+	Entries.Reset();
+	CellRanges.Reset();
+	Arenas.Reset();
+
+	for (ACapStoneCharacter* Character : Characters)
+	{
+		const FVector Location = Character->GetActorLocation();
+		Entries.Add({ Character, Location, Character->GetTeamID(), Character->GetArenaIndex(), GetCell(Location) });
+	}
+
+	Entries.Sort([](const FGridEntry& A, const FGridEntry& B)
+	{
+		return A.Cell.X != B.Cell.X ? A.Cell.X < B.Cell.X : A.Cell.Y < B.Cell.Y;
+	});
+
+	MinCell = FIntPoint(MAX_int32, MAX_int32);
+	MaxCell = FIntPoint(MIN_int32, MIN_int32);
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		const FIntPoint Cell = Entries[Index].Cell;
+		FIntPoint& Range = CellRanges.FindOrAdd(Cell, FIntPoint(Index, 0));
+		Range.Y++;
+
+		MinCell = MinCell.ComponentMin(Cell);
+		MaxCell = MaxCell.ComponentMax(Cell);
+
+		FArenaMembers& Arena = Arenas.FindOrAdd(Entries[Index].ArenaIndex);
+		Arena.EntryIndices.Add(Index);
+		Arena.TeamCounts.FindOrAdd(Entries[Index].TeamID)++;
+	}
+
+	bGridDirty = false;
+}
+
+void UCapStoneEnemySubsystem::QueryNearestEnemies(
+	const ACapStoneCharacter* Character, int32 MaxNum, TArray<ACapStoneCharacter*>& OutEnemies)
+{
+	OutEnemies.Reset();
+	if (!Character || MaxNum <= 0)
+	{
+		return;
+	}
+	if (bGridDirty)
+	{
+		RebuildGrid();
+	}
+	if (Entries.Num() == 0)
+	{
+		return;
+	}
+
+	const FVector Location = Character->GetActorLocation();
+	const int32 TeamID = Character->GetTeamID();
+	const int32 ArenaIndex = Character->GetArenaIndex();
+
+	// 같은 arena 의 다른 팀 인원보다 많이 찾을 수는 없다
+	const FArenaMembers* Arena = Arenas.Find(ArenaIndex);
+	if (!Arena)
+	{
+		return;
+	}
+	const int32* OwnTeamCount = Arena->TeamCounts.Find(TeamID);
+	const int32 ReachableNum = Arena->EntryIndices.Num() - (OwnTeamCount ? *OwnTeamCount : 0);
+	if (ReachableNum <= 0)
+	{
+		return;
+	}
+	const int32 WantedNum = FMath::Min(MaxNum, ReachableNum);
+
+	// 거리 오름차순으로 유지하는 작은 top-K 버퍼
+	TArray<TPair<float, ACapStoneCharacter*>, TInlineAllocator<UCapStoneEnemySubsystem::MaxEnemyNum + 1>> Nearest;
+	int32 SeenNum = 0;
+
+	auto AddCandidate = [&](const FGridEntry& Entry)
+	{
+		if (Entry.Character == Character || Entry.TeamID == TeamID || Entry.ArenaIndex != ArenaIndex)
+		{
+			return;
+		}
+		++SeenNum;
+
+		const float Distance = FVector::Dist(Location, Entry.Location);
+		if (Nearest.Num() == WantedNum && Distance >= Nearest.Last().Key)
+		{
+			return;
+		}
+
+		int32 Insert = Nearest.Num();
+		while (Insert > 0 && Nearest[Insert - 1].Key > Distance)
+		{
+			--Insert;
+		}
+		Nearest.Insert(TPair<float, ACapStoneCharacter*>(Distance, Entry.Character), Insert);
+		if (Nearest.Num() > WantedNum)
+		{
+			Nearest.Pop(EAllowShrinking::No);
+		}
+	};
+
+	if (ArenaIndex != INDEX_NONE || Arena->EntryIndices.Num() <= DirectScanArenaSize)
+	{
+		// 생성된 arena 는 상대가 하나뿐이라 grid 를 돌 필요 없이 arena 멤버만 본다
+		for (const int32 Index : Arena->EntryIndices)
+		{
+			AddCandidate(Entries[Index]);
+		}
+	}
+	else
+	{
+		const FIntPoint Center = GetCell(Location);
+		const int32 MaxRing = FMath::Max(
+			FMath::Max(FMath::Abs(Center.X - MinCell.X), FMath::Abs(MaxCell.X - Center.X)),
+			FMath::Max(FMath::Abs(Center.Y - MinCell.Y), FMath::Abs(MaxCell.Y - Center.Y)));
+
+		for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+		{
+			// 찾을 수 있는 적을 모두 봤거나, Ring 안의 cell 이 적어도 (Ring - 1) * CellSize 만큼 떨어져 있어 더 가까운 적이 없다
+			if (SeenNum == ReachableNum
+				|| (Nearest.Num() == WantedNum && (Ring - 1) * CellSize > Nearest.Last().Key))
+			{
+				break;
+			}
+
+			for (int32 X = Center.X - Ring; X <= Center.X + Ring; ++X)
+			{
+				const bool bEdgeColumn = X == Center.X - Ring || X == Center.X + Ring;
+				const int32 StepY = bEdgeColumn ? 1 : FMath::Max(2 * Ring, 1);
+
+				for (int32 Y = Center.Y - Ring; Y <= Center.Y + Ring; Y += StepY)
+				{
+					const FIntPoint* Range = CellRanges.Find(FIntPoint(X, Y));
+					if (!Range)
+					{
+						continue;
+					}
+
+					for (int32 Index = Range->X; Index < Range->X + Range->Y; ++Index)
+					{
+						AddCandidate(Entries[Index]);
+					}
+				}
+			}
+		}
+	}
+
+	for (const TPair<float, ACapStoneCharacter*>& Pair : Nearest)
+	{
+		OutEnemies.Add(Pair.Value);
+	}
+}
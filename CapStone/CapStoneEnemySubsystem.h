@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CapStoneEnemySubsystem.generated.h"
+
+class ACapStoneCharacter;
+
+/**
+ * 월드에 있는 모든 ACapStoneCharacter 를 XY 평면 uniform grid 에 올려두고
+ * 같은 arena 에서 TeamID 가 다른 가장 가까운 적 K 명을 찾아준다.
+ * 생성된 arena 처럼 인원이 적은 arena 는 grid 없이 arena 멤버만 훑고,
+ * 배치된 캐릭터가 모인 큰 arena 만 grid 를 링 단위로 넓혀 가며 찾는다.
+ * Grid 는 스텝마다 한 번 RefreshEnemyInformation() 에서 다시 만들어진다.
+ */
+UCLASS()
+class CAPSTONE_API UCapStoneEnemySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Number of nearest enemies kept per character */
+	static constexpr int32 MaxEnemyNum = 4;
+
+	/** Arenas with at most this many characters are scanned directly instead of through the grid */
+	static constexpr int32 DirectScanArenaSize = 16;
+
+	void RegisterCharacter(ACapStoneCharacter* Character);
+	void UnregisterCharacter(ACapStoneCharacter* Character);
+
+	/** Rebuilds the grid and every registered character's enemy information. Runs at most once per frame unless bForce. */
+	void RefreshEnemyInformation(bool bForce = false);
+
+	/** Fills OutEnemies with up to MaxNum enemies of Character, nearest first. */
+	void QueryNearestEnemies(const ACapStoneCharacter* Character, int32 MaxNum, TArray<ACapStoneCharacter*>& OutEnemies);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FGridEntry
+	{
+		ACapStoneCharacter* Character;
+		FVector Location;
+		int32 TeamID;
+		int32 ArenaIndex;
+		FIntPoint Cell;
+	};
+
+	/** Entries of one arena and how many of them each team has */
+	struct FArenaMembers
+	{
+		TArray<int32> EntryIndices;
+		TMap<int32, int32> TeamCounts;
+	};
+
+	void RebuildGrid();
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	UPROPERTY()
+	TArray<ACapStoneCharacter*> Characters;
+
+	// Cell 순서로 정렬된 entry, CellRanges 는 cell -> (시작 index, 개수)
+	TArray<FGridEntry> Entries;
+	TMap<FIntPoint, FIntPoint> CellRanges;
+	FIntPoint MinCell = FIntPoint::ZeroValue;
+	FIntPoint MaxCell = FIntPoint::ZeroValue;
+
+	// ArenaIndex -> 그 arena 의 entry
+	TMap<int32, FArenaMembers> Arenas;
+
+	float CellSize = 1000.f;
+
+	bool bGridDirty = true;
+	uint64 LastRefreshFrame = MAX_uint64;
+};
@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneExperienceLog.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "LearningAgentsCompletions.h"
+
+#include "CapStoneAgentSnapshot.h"
+#include "MyLearningAgentsInteractor.h"
+#include "MyLearningAgentsEnv.h"
+
+FCapStoneExperienceRecorder::~FCapStoneExperienceRecorder()
+{
+	Close();
+}
+
+bool FCapStoneExperienceRecorder::Open(const FString& InPath)
+{
+	Close();
+
+	Path = InPath;
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, false, false));
+	if (!File)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open experience log %s."), *Path);
+		return false;
+	}
+
+	bHeaderWritten = false;
+	NextEpisodeId = 0;
+	UE_LOG(LogTemp, Log, TEXT("Recording experience to %s."), *Path);
+	return true;
+}
+
+void FCapStoneExperienceRecorder::Close()
+{
+	if (!File)
+	{
+		return;
+	}
+
+	// 끝나지 않은 episode 는 마지막 record 를 Truncation 으로 표시해서 남긴다
+	for (FAgentEpisode& Episode : Episodes)
+	{
+		if (Episode.Records.Num() == 0)
+		{
+			continue;
+		}
+
+		FCapStoneExperienceRecord* Last = reinterpret_cast<FCapStoneExperienceRecord*>(
+			Episode.Records.GetData() + Episode.Records.Num() - Header.RecordSize);
+		Last->Completion = (uint8)ELearningAgentsCompletion::Truncation;
+
+		File->Write(Episode.Records.GetData(), Episode.Records.Num());
+		Episode.Records.Reset();
+	}
+
+	File->Flush();
+	File.Reset();
+
+	Episodes.Reset();
+	HasPending.Reset();
+}
+
+bool FCapStoneExperienceRecorder::WriteHeader(int32 ObservationNum, int32 ActionNum, int32 ObservationHash, int32 ActionHash)
+{
+	Header = FCapStoneExperienceLogHeader();
+	Header.ObservationNum = ObservationNum;
+	Header.ActionNum = ActionNum;
+	Header.RecordSize = sizeof(FCapStoneExperienceRecord) + (ObservationNum + ActionNum) * sizeof(float);
+	Header.ObservationCompatibilityHash = ObservationHash;
+	Header.ActionCompatibilityHash = ActionHash;
+
+	bHeaderWritten = File->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	return bHeaderWritten;
+}
+
+void FCapStoneExperienceRecorder::RecordStep(UMyLearningAgentsInteractor* Interactor, UMyLearningAgentsEnv* Env, const FCapStoneAgentSnapshot& Snapshot)
+{
+	if (!File || !Interactor || !Env)
+	{
+		return;
+	}
+
+	const int32 MaxAgentNum = Snapshot.GetMaxAgentNum();
+	if (Episodes.Num() < MaxAgentNum)
+	{
+		Episodes.SetNum(MaxAgentNum);
+		HasPending.SetNum(MaxAgentNum, false);
+	}
+
+	for (int32 AgentId = 0; AgentId < MaxAgentNum; ++AgentId)
+	{
+		if (!Snapshot.IsValid(AgentId))
+		{
+			continue;
+		}
+
+		// 1. 지난 결정 + 그 뒤에 모인 reward, completion
+		float Reward = 0.f;
+		ELearningAgentsCompletion Completion = ELearningAgentsCompletion::Running;
+		if (HasPending[AgentId] && Env->ConsumeAgentOutcome(AgentId, Reward, Completion))
+		{
+			AppendRecord(AgentId, Reward, (uint8)Completion);
+		}
+
+		// 2. 이번 결정
+		int32 ObservationHash = 0;
+		int32 ActionHash = 0;
+		Interactor->GetObservationVector(ObservationVector, ObservationHash, AgentId);
+		Interactor->GetActionVector(ActionVector, ActionHash, AgentId);
+
+		if (!bHeaderWritten)
+		{
+			if (!WriteHeader(ObservationVector.Num(), ActionVector.Num(), ObservationHash, ActionHash))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not write experience log header, closing %s."), *Path);
+				Close();
+				return;
+			}
+			PendingObservations.SetNumZeroed(MaxAgentNum * Header.ObservationNum);
+			PendingActions.SetNumZeroed(MaxAgentNum * Header.ActionNum);
+		}
+
+		if (ObservationVector.Num() != (int32)Header.ObservationNum || ActionVector.Num() != (int32)Header.ActionNum)
+		{
+			HasPending[AgentId] = false;
+			continue;
+		}
+
+		FMemory::Memcpy(&PendingObservations[AgentId * Header.ObservationNum], ObservationVector.GetData(), Header.ObservationNum * sizeof(float));
+		FMemory::Memcpy(&PendingActions[AgentId * Header.ActionNum], ActionVector.GetData(), Header.ActionNum * sizeof(float));
+		HasPending[AgentId] = true;
+	}
+}
+
+void FCapStoneExperienceRecorder::AppendRecord(int32 AgentId, float Reward, uint8 Completion)
+{
+	FAgentEpisode& Episode = Episodes[AgentId];
+	if (Episode.EpisodeId == INDEX_NONE)
+	{
+		Episode.EpisodeId = NextEpisodeId++;
+	}
+
+	const int32 Offset = Episode.Records.AddUninitialized(Header.RecordSize);
+	uint8* Data = Episode.Records.GetData() + Offset;
+
+	FCapStoneExperienceRecord Record;
+	Record.AgentId = AgentId;
+	Record.EpisodeId = Episode.EpisodeId;
+	Record.Reward = Reward;
+	Record.Completion = Completion;
+	FMemory::Memcpy(Data, &Record, sizeof(Record));
+	Data += sizeof(Record);
+
+	FMemory::Memcpy(Data, &PendingObservations[AgentId * Header.ObservationNum], Header.ObservationNum * sizeof(float));
+	Data += Header.ObservationNum * sizeof(float);
+	FMemory::Memcpy(Data, &PendingActions[AgentId * Header.ActionNum], Header.ActionNum * sizeof(float));
+
+	// episode 가 끝나면 통째로 append, 버퍼 용량은 다음 episode 를 위해 남긴다
+	if (Completion != (uint8)ELearningAgentsCompletion::Running)
+	{
+		File->Write(Episode.Records.GetData(), Episode.Records.Num());
+		Episode.Records.Reset();
+		Episode.EpisodeId = INDEX_NONE;
+	}
+}
+
+bool FCapStoneExperienceReader::Open(const FString& InPath)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*InPath));
+	if (!MappedFile || MappedFile->GetFileSize() < (int64)sizeof(FCapStoneExperienceLogHeader))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not map experience log %s."), *InPath);
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!MappedRegion)
+	{
+		Close();
+		return false;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	Header = reinterpret_cast<const FCapStoneExperienceLogHeader*>(Data);
+	if (Header->Magic != FCapStoneExperienceLogHeader::ExpectedMagic
+		|| Header->Version != FCapStoneExperienceLogHeader::ExpectedVersion
+		|| Header->RecordSize != sizeof(FCapStoneExperienceRecord) + (Header->ObservationNum + Header->ActionNum) * sizeof(float))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a valid experience log."), *InPath);
+		Close();
+		return false;
+	}
+
+	RecordData = Data + Header->HeaderSize;
+	// 마지막 record 가 잘렸으면 버린다
+	RecordNum = ((int64)MappedRegion->GetMappedSize() - Header->HeaderSize) / Header->RecordSize;
+
+	// record header 만 훑어서 episode 경계를 찾는다
+	int64 Start = 0;
+	for (int64 Index = 0; Index < RecordNum; ++Index)
+	{
+		const FCapStoneExperienceRecord& Record =
+			*reinterpret_cast<const FCapStoneExperienceRecord*>(RecordData + Index * Header->RecordSize);
+		if (Record.Completion != (uint8)ELearningAgentsCompletion::Running)
+		{
+			EpisodeStarts.Add(Start);
+			EpisodeLengths.Add(int32(Index + 1 - Start));
+			Start = Index + 1;
+		}
+	}
+
+	return true;
+}
+
+void FCapStoneExperienceReader::Close()
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	Header = nullptr;
+	RecordData = nullptr;
+	RecordNum = 0;
+	EpisodeStarts.Reset();
+	EpisodeLengths.Reset();
+}
+
+FCapStoneExperienceEpisode FCapStoneExperienceReader::GetEpisode(int32 EpisodeIndex) const
+{
+	FCapStoneExperienceEpisode Episode;
+	if (!EpisodeStarts.IsValidIndex(EpisodeIndex))
+	{
+		return Episode;
+	}
+
+	Episode.Header = Header;
+	Episode.Records = RecordData + EpisodeStarts[EpisodeIndex] * Header->RecordSize;
+	Episode.StepNum = EpisodeLengths[EpisodeIndex];
+	return Episode;
+}
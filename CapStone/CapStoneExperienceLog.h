@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+
+class UMyLearningAgentsInteractor;
+class UMyLearningAgentsEnv;
+struct FCapStoneAgentSnapshot;
+
+/**
+ * Experience log 파일 형식 (little endian).
+ *
+ *   FCapStoneExperienceLogHeader
+ *   record 0, record 1, ... (RecordSize 바이트 고정)
+ *
+ * Record = FCapStoneExperienceRecord + float[ObservationNum] + float[ActionNum].
+ * 한 episode 의 record 는 항상 연속으로 쓰이고 마지막 record 의 Completion 이 Running 이 아니다.
+ */
+struct FCapStoneExperienceLogHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x50585343; // "CSXP"
+	static constexpr uint32 ExpectedVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = ExpectedVersion;
+	uint32 HeaderSize = sizeof(FCapStoneExperienceLogHeader);
+	uint32 RecordSize = 0;
+	uint32 ObservationNum = 0;
+	uint32 ActionNum = 0;
+	int32 ObservationCompatibilityHash = 0;
+	int32 ActionCompatibilityHash = 0;
+};
+
+struct FCapStoneExperienceRecord
+{
+	int32 AgentId = INDEX_NONE;
+	int32 EpisodeId = INDEX_NONE;
+	float Reward = 0.f;
+	// ELearningAgentsCompletion
+	uint8 Completion = 0;
+	uint8 Padding[3] = {};
+};
+
+static_assert(sizeof(FCapStoneExperienceLogHeader) == 32, "Experience log header layout changed");
+static_assert(sizeof(FCapStoneExperienceRecord) == 16, "Experience record layout changed");
+
+/**
+ * AMyLearningManager 가 스텝마다 각 agent 의 observation, action, reward, completion 을 기록한다.
+ * Episode 가 끝날 때까지 agent 별 버퍼에 모아 두었다가 한 번에 append 한다.
+ * 버퍼는 용량을 유지하므로 처음 몇 episode 이후에는 스텝마다 할당하지 않는다.
+ */
+class CAPSTONE_API FCapStoneExperienceRecorder
+{
+public:
+	~FCapStoneExperienceRecorder();
+
+	bool Open(const FString& InPath);
+	void Close();
+
+	bool IsOpen() const { return File.IsValid(); }
+
+	/**
+	 * Call after every decision. Pairs the previous decision's observation and action with the reward
+	 * and completion the environment gathered since, then captures this decision.
+	 */
+	void RecordStep(UMyLearningAgentsInteractor* Interactor, UMyLearningAgentsEnv* Env, const FCapStoneAgentSnapshot& Snapshot);
+
+private:
+	struct FAgentEpisode
+	{
+		TArray<uint8> Records;
+		int32 EpisodeId = INDEX_NONE;
+	};
+
+	bool WriteHeader(int32 ObservationNum, int32 ActionNum, int32 ObservationHash, int32 ActionHash);
+	void AppendRecord(int32 AgentId, float Reward, uint8 Completion);
+
+	FString Path;
+	TUniquePtr<IFileHandle> File;
+	FCapStoneExperienceLogHeader Header;
+	bool bHeaderWritten = false;
+
+	TArray<FAgentEpisode> Episodes;
+
+	// 지난 결정의 observation, action, AgentId 로 index
+	TArray<float> PendingObservations;
+	TArray<float> PendingActions;
+	TBitArray<> HasPending;
+
+	// GetObservationVector, GetActionVector 버퍼
+	TArray<float> ObservationVector;
+	TArray<float> ActionVector;
+
+	int32 NextEpisodeId = 0;
+};
+
+/** One episode of a mapped log. Points straight into the mapping. */
+struct FCapStoneExperienceEpisode
+{
+	const uint8* Records = nullptr;
+	int32 StepNum = 0;
+	const FCapStoneExperienceLogHeader* Header = nullptr;
+
+	const FCapStoneExperienceRecord& GetRecord(int32 Step) const
+	{
+		return *reinterpret_cast<const FCapStoneExperienceRecord*>(Records + (SIZE_T)Step * Header->RecordSize);
+	}
+
+	TConstArrayView<float> GetObservation(int32 Step) const
+	{
+		return TConstArrayView<float>(reinterpret_cast<const float*>(&GetRecord(Step) + 1), Header->ObservationNum);
+	}
+
+	TConstArrayView<float> GetAction(int32 Step) const
+	{
+		return TConstArrayView<float>(GetObservation(Step).GetData() + Header->ObservationNum, Header->ActionNum);
+	}
+
+	int32 GetAgentId() const { return GetRecord(0).AgentId; }
+	int32 GetEpisodeId() const { return GetRecord(0).EpisodeId; }
+};
+
+/** Memory-maps a log written by FCapStoneExperienceRecorder. No data is copied. */
+class CAPSTONE_API FCapStoneExperienceReader
+{
+public:
+	bool Open(const FString& InPath);
+	void Close();
+
+	const FCapStoneExperienceLogHeader* GetHeader() const { return Header; }
+
+	int32 GetEpisodeNum() const { return EpisodeStarts.Num(); }
+	FCapStoneExperienceEpisode GetEpisode(int32 EpisodeIndex) const;
+
+	int64 GetRecordNum() const { return RecordNum; }
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	const FCapStoneExperienceLogHeader* Header = nullptr;
+	const uint8* RecordData = nullptr;
+	int64 RecordNum = 0;
+
+	// Episode 의 첫 record index 와 길이
+	TArray<int64> EpisodeStarts;
+	TArray<int32> EpisodeLengths;
+};
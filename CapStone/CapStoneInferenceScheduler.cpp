@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneInferenceScheduler.h"
+
+#include "Tasks/Task.h"
+#include "LearningAgentsManager.h"
+#include "LearningAgentsPolicy.h"
+#include "LearningArray.h"
+
+#include "MyLearningAgentsInteractor.h"
+#include "CapStoneRLStats.h"
+
+void FCapStoneInferenceScheduler::Init(
+	const ULearningAgentsManager* InManager, ULearningAgentsPolicy* InPolicy, UMyLearningAgentsInteractor* InInteractor, float InFrameBudgetMs)
+{
+	Flush();
+
+	Manager = InManager;
+	Policy = InPolicy;
+	Interactor = InInteractor;
+	MaxAgentNum = FMath::Max(InManager ? InManager->GetMaxAgentNum() : 0, 1);
+	FrameBudgetMs = FMath::Max(InFrameBudgetMs, 0.f);
+
+	DecisionBatchSize = MaxAgentNum;
+	Cursor = 0;
+	DecisionMask.Init(false, MaxAgentNum);
+	BatchAgentIds.Reset(MaxAgentNum);
+}
+
+void FCapStoneInferenceScheduler::Flush()
+{
+	if (EvaluateTask.IsValid())
+	{
+		EvaluateTask.Wait();
+		EvaluateTask = UE::Tasks::FTask();
+	}
+	bHasPendingActions = false;
+}
+
+void FCapStoneInferenceScheduler::Tick()
+{
+	if (!Policy || !Interactor)
+	{
+		return;
+	}
+
+	// Worker 가 아직 평가 중이면 기다리지 않고 이전 command 를 유지한다
+	if (EvaluateTask.IsValid() && !EvaluateTask.IsCompleted())
+	{
+		Interactor->HoldLastCommands();
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// 지난 batch 는 새 action 을 받고 나머지는 이전 command 를 유지한다
+	if (bHasPendingActions)
+	{
+		Interactor->PerformActions(UE::Learning::FIndexSet(BatchAgentIds));
+		Interactor->HoldLastCommands(&DecisionMask);
+		bHasPendingActions = false;
+	}
+	else
+	{
+		Interactor->HoldLastCommands();
+	}
+
+	SelectBatch();
+	if (BatchAgentIds.Num() == 0)
+	{
+		UpdateBatchSize((FPlatformTime::Seconds() - StartTime) * 1000.0);
+		return;
+	}
+
+	// 이번 batch 의 observation 만 모은다
+	Interactor->GatherObservations(UE::Learning::FIndexSet(BatchAgentIds));
+
+	UpdateBatchSize((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	// Observation 버퍼와 BatchAgentIds 는 task 가 끝날 때까지 game thread 가 건드리지 않는다
+	ULearningAgentsPolicy* TaskPolicy = Policy;
+	const TArray<int32>* TaskAgentIds = &BatchAgentIds;
+	EvaluateTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [TaskPolicy, TaskAgentIds]()
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("CapStoneRL::AsyncEvaluatePolicy", CapStoneRLChannel);
+
+		const UE::Learning::FIndexSet AgentSet(*TaskAgentIds);
+		TaskPolicy->EncodeObservations(AgentSet);
+		TaskPolicy->EvaluatePolicy(AgentSet);
+		TaskPolicy->DecodeAndSampleActions(ActionNoiseScale, AgentSet);
+	});
+	bHasPendingActions = true;
+}
+
+void FCapStoneInferenceScheduler::SelectBatch()
+{
+	auto IsEligible = [this](int32 AgentId)
+	{
+		return Manager->HasAgent(AgentId)
+			&& (!EligibleMask || (EligibleMask->IsValidIndex(AgentId) && (*EligibleMask)[AgentId]));
+	};
+
+	// Cursor 부터 eligible agent 를 DecisionBatchSize 개까지 고른다
+	DecisionMask.SetRange(0, MaxAgentNum, false);
+	int32 Selected = 0;
+	int32 Visited = 0;
+	for (; Visited < MaxAgentNum && Selected < DecisionBatchSize; ++Visited)
+	{
+		const int32 AgentId = (Cursor + Visited) % MaxAgentNum;
+		if (IsEligible(AgentId))
+		{
+			DecisionMask[AgentId] = true;
+			++Selected;
+		}
+	}
+	Cursor = (Cursor + Visited) % MaxAgentNum;
+
+	// FIndexSet 은 정렬된 id 를 기대하므로 mask 순서로 만든다
+	BatchAgentIds.Reset();
+	for (TConstSetBitIterator<> It(DecisionMask); It; ++It)
+	{
+		BatchAgentIds.Add(It.GetIndex());
+	}
+}
+
+void FCapStoneInferenceScheduler::UpdateBatchSize(double GameThreadMs)
+{
+	if (FrameBudgetMs <= 0.f)
+	{
+		DecisionBatchSize = MaxAgentNum;
+		return;
+	}
+
+	// 예산을 넘으면 비율만큼 줄이고, 여유가 있으면 천천히 늘린다
+	if (GameThreadMs > FrameBudgetMs)
+	{
+		DecisionBatchSize = FMath::Max(1, FMath::FloorToInt32(DecisionBatchSize * (FrameBudgetMs / GameThreadMs) * 0.9));
+	}
+	else if (GameThreadMs < FrameBudgetMs * 0.75)
+	{
+		DecisionBatchSize = FMath::Min(MaxAgentNum, DecisionBatchSize + FMath::Max(1, DecisionBatchSize / 4));
+	}
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+
+class ULearningAgentsManager;
+class ULearningAgentsPolicy;
+class UMyLearningAgentsInteractor;
+
+/**
+ * Inference 모드에서 Policy->RunInference() 를 game thread 와 worker task 로 나눈다.
+ *
+ * 프레임 N: 이전 task 가 끝났으면 그 batch 에 action 을 적용하고, 다음 batch 를 골라 그 agent 의 observation 만 모은 뒤
+ *           encoder, policy, decoder 평가를 같은 batch 로 worker task 에 넘긴다.
+ * 프레임 N+1: 그 결과를 적용한다. Task 가 아직 안 끝났으면 기다리지 않고 마지막 command 를 유지한다.
+ * Batch 밖의 agent 는 gather, 평가 없이 마지막 이동, 회전만 유지한다.
+ *
+ * Game thread 에서 쓰는 시간 (action decode/apply + observation gather) 이 FrameBudgetMs 를 넘으면
+ * batch 크기를 줄이고 round-robin 으로 돌린다.
+ * Task 가 도는 동안에는 agent 를 추가하거나 지우면 안 되므로 agent 가 바뀌기 전에 Flush() 를 부른다 (AMyLearningManager::FlushAgentTasks).
+ */
+class CAPSTONE_API FCapStoneInferenceScheduler
+{
+public:
+	void Init(const ULearningAgentsManager* InManager, ULearningAgentsPolicy* InPolicy, UMyLearningAgentsInteractor* InInteractor, float InFrameBudgetMs);
+
+	bool IsInitialized() const { return Policy != nullptr; }
+
+	/** Game thread, once per decision step */
+	void Tick();
+
+	/** Waits for the worker task and drops its result. The next Tick starts a new batch. */
+	void Flush();
+
+	/** True while the worker task is still reading the networks */
+	bool IsBusy() const { return EvaluateTask.IsValid() && !EvaluateTask.IsCompleted(); }
+
+	int32 GetDecisionBatchSize() const { return DecisionBatchSize; }
+
+	/** Only agents in this mask are gathered and evaluated (FCapStoneDecisionLOD). nullptr allows every agent. */
+	void SetEligibleMask(const TBitArray<>* InEligibleMask) { EligibleMask = InEligibleMask; }
+
+private:
+	/** Picks up to DecisionBatchSize eligible agents from Cursor into DecisionMask and BatchAgentIds */
+	void SelectBatch();
+	void UpdateBatchSize(double GameThreadMs);
+
+	const ULearningAgentsManager* Manager = nullptr;
+	ULearningAgentsPolicy* Policy = nullptr;
+	UMyLearningAgentsInteractor* Interactor = nullptr;
+
+	UE::Tasks::FTask EvaluateTask;
+	bool bHasPendingActions = false;
+
+	// Inference 는 noise 없이 policy 의 평균 action 을 쓴다
+	static constexpr float ActionNoiseScale = 0.f;
+
+	float FrameBudgetMs = 2.f;
+	int32 MaxAgentNum = 0;
+
+	// 한 프레임에 새 action 을 받는 agent 수와 round-robin 시작 위치
+	int32 DecisionBatchSize = 0;
+	int32 Cursor = 0;
+
+	// 평가 중이거나 적용을 기다리는 batch. Task 가 끝날 때까지 바꾸지 않는다
+	TBitArray<> DecisionMask;
+	TArray<int32> BatchAgentIds;
+
+	const TBitArray<>* EligibleMask = nullptr;
+};
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneKinematicArm.h"
+
+#include "CapStoneCharacter.h"
+#include "TwoBoneIK.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+
+bool FCapStoneKinematicArm::Init(const USkeletalMeshComponent* Mesh, FName UpperArm, FName LowerArm, FName Hand,
+	const FQuat& PointRotation, const UBoxComponent* WeaponBox)
+{
+	bValid = false;
+	bHasWeapon = false;
+
+	if (!Mesh || Mesh->GetBoneIndex(UpperArm) == INDEX_NONE || Mesh->GetBoneIndex(LowerArm) == INDEX_NONE || Mesh->GetBoneIndex(Hand) == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FTransform ActorTransform = Mesh->GetOwner()->GetActorTransform();
+	const FVector Shoulder = Mesh->GetSocketLocation(UpperArm);
+	const FVector Elbow = Mesh->GetSocketLocation(LowerArm);
+	const FTransform HandWorld = Mesh->GetSocketTransform(Hand);
+
+	ShoulderOffset = ActorTransform.InverseTransformPosition(Shoulder);
+	ElbowHintOffset = ActorTransform.InverseTransformPosition(Elbow);
+	UpperLength = FVector::Dist(Shoulder, Elbow);
+	LowerLength = FVector::Dist(Elbow, HandWorld.GetLocation());
+
+	// physics handle grab 처럼 point 와 손의 회전 차이를 유지한다
+	HandRotationOffset = PointRotation.Inverse() * HandWorld.GetRotation();
+
+	ShoulderLocation = Shoulder;
+	ElbowLocation = Elbow;
+	HandTransform = HandWorld;
+
+	if (WeaponBox)
+	{
+		// box 의 가장 긴 축을 선분으로, 나머지 축 중 큰 쪽을 반지름으로 본다
+		const FVector Extent = WeaponBox->GetScaledBoxExtent();
+		const int32 Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+
+		FVector HalfAxis = FVector::ZeroVector;
+		HalfAxis[Axis] = Extent[Axis];
+		FVector Side = Extent;
+		Side[Axis] = 0.f;
+
+		const FTransform BoxWorld = WeaponBox->GetComponentTransform();
+		const FVector Start = BoxWorld.TransformPositionNoScale(-HalfAxis);
+		const FVector End = BoxWorld.TransformPositionNoScale(HalfAxis);
+
+		WeaponStart = HandWorld.InverseTransformPositionNoScale(Start);
+		WeaponEnd = HandWorld.InverseTransformPositionNoScale(End);
+		WeaponRadius = Side.GetMax();
+		bHasWeapon = true;
+	}
+
+	bValid = UpperLength > UE_KINDA_SMALL_NUMBER && LowerLength > UE_KINDA_SMALL_NUMBER;
+	return bValid;
+}
+
+void FCapStoneKinematicArm::Solve(const FTransform& ActorTransform, const FVector& TargetLocation, const FQuat& TargetRotation)
+{
+	if (!bValid)
+	{
+		return;
+	}
+
+	const FVector Shoulder = ActorTransform.TransformPosition(ShoulderOffset);
+	const FVector ElbowHint = ActorTransform.TransformPosition(ElbowHintOffset);
+
+	FVector OutElbow;
+	FVector OutHand;
+	AnimationCore::SolveTwoBoneIK(
+		Shoulder, ElbowLocation, HandTransform.GetLocation(),
+		ElbowHint, TargetLocation,
+		OutElbow, OutHand,
+		UpperLength, LowerLength,
+		false, 1.0, 1.0);
+
+	ShoulderLocation = Shoulder;
+	ElbowLocation = OutElbow;
+	HandTransform = FTransform(TargetRotation * HandRotationOffset, OutHand);
+}
+
+bool FCapStoneKinematicArm::TestContact(const ACapStoneCharacter* Other) const
+{
+	if (!bValid || !bHasWeapon || !Other)
+	{
+		return false;
+	}
+
+	const UCapsuleComponent* Capsule = Other->GetCapsuleComponent();
+	const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	const FVector CapsuleCenter = Capsule->GetComponentLocation();
+	const FVector CapsuleAxis = Capsule->GetUpVector() * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+
+	// 멀리 있으면 선분 계산 없이 끝낸다
+	const float Reach = CapsuleRadius + WeaponRadius + Capsule->GetScaledCapsuleHalfHeight() + FMath::Max(WeaponStart.Size(), WeaponEnd.Size());
+	if (FVector::DistSquared(HandTransform.GetLocation(), CapsuleCenter) > FMath::Square(Reach))
+	{
+		return false;
+	}
+
+	FVector OnWeapon;
+	FVector OnCapsule;
+	FMath::SegmentDistToSegmentSafe(
+		HandTransform.TransformPositionNoScale(WeaponStart), HandTransform.TransformPositionNoScale(WeaponEnd),
+		CapsuleCenter - CapsuleAxis, CapsuleCenter + CapsuleAxis,
+		OnWeapon, OnCapsule);
+
+	return FVector::DistSquared(OnWeapon, OnCapsule) <= FMath::Square(CapsuleRadius + WeaponRadius);
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USkeletalMeshComponent;
+class UBoxComponent;
+class ACapStoneCharacter;
+
+/**
+ * 팔 하나 (upperarm, lowerarm, hand) 를 physics handle 대신 해석적 two-bone IK 로 푼다.
+ * 어깨와 팔꿈치 방향은 Init 시점의 자세를 actor 기준으로 저장해 두고, 스텝마다 hand point 로 손과 팔꿈치 위치를 구한다.
+ * 무기 충돌도 physics 없이 무기 box 의 긴 축 선분과 상대 capsule 사이 거리로 검사한다.
+ */
+struct CAPSTONE_API FCapStoneKinematicArm
+{
+	/**
+	 * Reads the current pose. PointRotation is the hand point's rotation at this moment,
+	 * the hand keeps the same offset to it like a physics handle grab does.
+	 */
+	bool Init(const USkeletalMeshComponent* Mesh, FName UpperArm, FName LowerArm, FName Hand,
+		const FQuat& PointRotation, const UBoxComponent* WeaponBox);
+
+	/** Solves the chain for a world space hand target */
+	void Solve(const FTransform& ActorTransform, const FVector& TargetLocation, const FQuat& TargetRotation);
+
+	/** True when the weapon segment touches Other's capsule */
+	bool TestContact(const ACapStoneCharacter* Other) const;
+
+	bool IsValid() const { return bValid; }
+
+	// Solve 결과, world 기준. AnimBP 에서 two-bone IK 노드로 메시에 적용할 수 있다
+	FVector ShoulderLocation = FVector::ZeroVector;
+	FVector ElbowLocation = FVector::ZeroVector;
+	FTransform HandTransform = FTransform::Identity;
+
+private:
+	bool bValid = false;
+
+	// actor 기준
+	FVector ShoulderOffset = FVector::ZeroVector;
+	FVector ElbowHintOffset = FVector::ZeroVector;
+
+	double UpperLength = 0.0;
+	double LowerLength = 0.0;
+
+	FQuat HandRotationOffset = FQuat::Identity;
+
+	// 무기: hand 기준 선분 양 끝과 두께
+	bool bHasWeapon = false;
+	FVector WeaponStart = FVector::ZeroVector;
+	FVector WeaponEnd = FVector::ZeroVector;
+	float WeaponRadius = 0.f;
+};
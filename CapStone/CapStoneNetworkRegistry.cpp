@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneNetworkRegistry.h"
+
+#include "Misc/Paths.h"
+#include "LearningAgentsNeuralNetwork.h"
+
+FString UCapStoneNetworkRegistry::MakeKey(const ULearningAgentsNeuralNetwork* Template, const FString& SnapshotPath)
+{
+	FString NormalizedPath = FPaths::ConvertRelativePathToFull(SnapshotPath);
+	FPaths::NormalizeFilename(NormalizedPath);
+	return Template->GetPathName() + TEXT("|") + NormalizedPath;
+}
+
+ULearningAgentsNeuralNetwork* UCapStoneNetworkRegistry::AcquireNetwork(
+	ULearningAgentsNeuralNetwork* Template, const FString& SnapshotPath, bool& bOutCreated)
+{
+	bOutCreated = false;
+	if (!Template)
+	{
+		return nullptr;
+	}
+
+	const FString Key = MakeKey(Template, SnapshotPath);
+	if (FEntry* Entry = Entries.Find(Key))
+	{
+		Entry->ReferenceNum++;
+		return Entry->Network;
+	}
+
+	// asset 자체는 건드리지 않도록 transient 복사본을 만든다
+	ULearningAgentsNeuralNetwork* Network = DuplicateObject<ULearningAgentsNeuralNetwork>(Template, this);
+	Network->SetFlags(RF_Transient);
+
+	Entries.Add(Key, { Network, 1 });
+	Networks.Add(Network);
+	bOutCreated = true;
+
+	UE_LOG(LogTemp, Log, TEXT("Shared network %s created for %s."), *Template->GetName(),
+		SnapshotPath.IsEmpty() ? TEXT("(no snapshot)") : *SnapshotPath);
+	return Network;
+}
+
+void UCapStoneNetworkRegistry::ReleaseNetwork(ULearningAgentsNeuralNetwork* Network)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (It->Value.Network == Network)
+		{
+			if (--It->Value.ReferenceNum <= 0)
+			{
+				Networks.RemoveSingleSwap(Network);
+				It.RemoveCurrent();
+			}
+			return;
+		}
+	}
+}
+
+int32 UCapStoneNetworkRegistry::GetReferenceNum(const ULearningAgentsNeuralNetwork* Network) const
+{
+	for (const TPair<FString, FEntry>& Pair : Entries)
+	{
+		if (Pair.Value.Network == Network)
+		{
+			return Pair.Value.ReferenceNum;
+		}
+	}
+	return 0;
+}
+
+void UCapStoneNetworkRegistry::Deinitialize()
+{
+	Entries.Empty();
+	Networks.Empty();
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "CapStoneNetworkRegistry.generated.h"
+
+class ULearningAgentsNeuralNetwork;
+
+/**
+ * Inference 전용 network 를 process 전체에서 공유한다.
+ * (network asset, snapshot 파일) 이 같은 manager 들은 같은 ULearningAgentsNeuralNetwork 복사본을 받는다.
+ * 가중치는 처음 만든 manager 가 한 번만 초기화하고 snapshot 을 읽으며 이후에는 바뀌지 않는다.
+ * 각 policy 는 이 network 로 자기 inference 인스턴스 (activation buffer) 만 따로 만든다.
+ */
+UCLASS()
+class CAPSTONE_API UCapStoneNetworkRegistry : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Returns the shared copy of Template for SnapshotPath and adds a reference.
+	 * bOutCreated is true for the first caller, which must initialize it and load the snapshot.
+	 */
+	ULearningAgentsNeuralNetwork* AcquireNetwork(ULearningAgentsNeuralNetwork* Template, const FString& SnapshotPath, bool& bOutCreated);
+
+	/** Drops a reference. The copy is released when no manager uses it. */
+	void ReleaseNetwork(ULearningAgentsNeuralNetwork* Network);
+
+	int32 GetReferenceNum(const ULearningAgentsNeuralNetwork* Network) const;
+
+	virtual void Deinitialize() override;
+
+private:
+	struct FEntry
+	{
+		ULearningAgentsNeuralNetwork* Network = nullptr;
+		int32 ReferenceNum = 0;
+	};
+
+	static FString MakeKey(const ULearningAgentsNeuralNetwork* Template, const FString& SnapshotPath);
+
+	TMap<FString, FEntry> Entries;
+
+	// GC 에서 살려 두기 위한 목록
+	UPROPERTY()
+	TArray<ULearningAgentsNeuralNetwork*> Networks;
+};
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneObservation.h"
+
+void FCapStoneAgentObservation::Fill(const FCapStoneAgentSnapshot& Snapshot, int32 AgentId)
+{
+	Transform = Snapshot.Transform[AgentId];
+	Rotation = Snapshot.Rotation[AgentId];
+
+	MyLocation = Snapshot.Location[AgentId];
+	MyDirection = Snapshot.Forward[AgentId];
+
+	EnemyNum = FMath::Min(Snapshot.EnemyNum[AgentId], MaxEnemyNum);
+	for (int32 Index = 0; Index < EnemyNum; ++Index)
+	{
+		const int32 Slot = FCapStoneAgentSnapshot::EnemyIndex(AgentId, Index);
+		Enemy[Index].Location = Snapshot.EnemyLocation[Slot];
+		Enemy[Index].Direction = Snapshot.EnemyDirection[Slot];
+	}
+
+	ArmPoint.RLocation = Snapshot.RightPointLocation[AgentId];
+	ArmPoint.RRotation = Snapshot.RightPointRotation[AgentId];
+	ArmPoint.LLocation = Snapshot.LeftPointLocation[AgentId];
+	ArmPoint.LRotation = Snapshot.LeftPointRotation[AgentId];
+}
+
+void FCapStoneLocalObservation::Encode(const FCapStoneAgentObservation& Observation)
+{
+	const FTransform& Transform = Observation.Transform;
+	const FQuat InverseRotation = Observation.Rotation.Quaternion().Inverse();
+
+	MyLocation = Transform.InverseTransformPosition(Observation.MyLocation);
+	MyDirection = Transform.InverseTransformVectorNoScale(Observation.MyDirection);
+
+	EnemyNum = Observation.EnemyNum;
+	for (int32 Index = 0; Index < EnemyNum; ++Index)
+	{
+		EnemyLocation[Index] = Transform.InverseTransformPosition(Observation.Enemy[Index].Location);
+		EnemyDirection[Index] = Transform.InverseTransformVectorNoScale(Observation.Enemy[Index].Direction);
+	}
+
+	RLocation = Transform.InverseTransformPosition(Observation.ArmPoint.RLocation);
+	RRotation = (InverseRotation * Observation.ArmPoint.RRotation.Quaternion()).Rotator();
+	LLocation = Transform.InverseTransformPosition(Observation.ArmPoint.LLocation);
+	LRotation = (InverseRotation * Observation.ArmPoint.LRotation.Quaternion()).Rotator();
+
+	bValid = true;
+}
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CapStoneAgentSnapshot.h"
+
+#include "CoreMinimal.h"
+#include "CapStoneObservation.generated.h"
+
+/** One entry of the enemy observation array, in world space */
+USTRUCT(BlueprintType)
+struct CAPSTONE_API FCapStoneEnemyObservation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector Direction = FVector::ForwardVector;
+};
+
+/** Right and left hand target points, in world space */
+USTRUCT(BlueprintType)
+struct CAPSTONE_API FCapStoneArmPointObservation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector RLocation = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FRotator RRotation = FRotator::ZeroRotator;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector LLocation = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FRotator LRotation = FRotator::ZeroRotator;
+};
+
+/**
+ * Agent 하나의 observation.
+ * 앞의 ObservedFieldNum 개 필드가 observation 이고 그 순서가 곧 observation vector 순서다.
+ * UMyLearningAgentsInteractor 는 schema 이름을 이 struct 의 reflection 에서 읽는다.
+ * 뒤의 필드는 인코딩에만 쓴다: Location 은 Transform, Rotation 은 Rotation 기준 상대값으로 인코딩된다.
+ */
+USTRUCT(BlueprintType)
+struct CAPSTONE_API FCapStoneAgentObservation
+{
+	GENERATED_BODY()
+
+	static constexpr int32 MaxEnemyNum = FCapStoneAgentSnapshot::MaxEnemyNum;
+
+	/** MyLocation, MyDirection, Enemy, ArmPoint */
+	static constexpr int32 ObservedFieldNum = 4;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector MyLocation = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FVector MyDirection = FVector::ForwardVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FCapStoneEnemyObservation Enemy[MaxEnemyNum];
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FCapStoneArmPointObservation ArmPoint;
+
+	// 여기부터는 observation 이 아니다
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 EnemyNum = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FTransform Transform;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	/** Copies one agent's row out of the snapshot */
+	void Fill(const FCapStoneAgentSnapshot& Snapshot, int32 AgentId);
+};
+
+/**
+ * FCapStoneAgentObservation 을 agent 기준 좌표로 미리 바꿔 둔 것.
+ * Observation object 에 넣을 때는 이미 agent 기준이므로 identity 기준을 쓴다.
+ */
+struct CAPSTONE_API FCapStoneLocalObservation
+{
+	static constexpr int32 MaxEnemyNum = FCapStoneAgentObservation::MaxEnemyNum;
+
+	bool bValid = false;
+
+	FVector MyLocation = FVector::ZeroVector;
+	FVector MyDirection = FVector::ForwardVector;
+
+	int32 EnemyNum = 0;
+	FVector EnemyLocation[MaxEnemyNum];
+	FVector EnemyDirection[MaxEnemyNum];
+
+	FVector RLocation = FVector::ZeroVector;
+	FRotator RRotation = FRotator::ZeroRotator;
+	FVector LLocation = FVector::ZeroVector;
+	FRotator LRotation = FRotator::ZeroRotator;
+
+	/** Locations and directions relative to Transform, rotations relative to Rotation. Thread safe. */
+	void Encode(const FCapStoneAgentObservation& Observation);
+};
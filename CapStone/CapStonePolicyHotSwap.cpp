@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStonePolicyHotSwap.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "LearningAgentsPolicy.h"
+#include "LearningAgentsNeuralNetwork.h"
+#include "LearningNeuralNetwork.h"
+
+namespace
+{
+	ULearningAgentsNeuralNetwork* GetNetworkAsset(ULearningAgentsPolicy* Policy, int32 Index)
+	{
+		switch (Index)
+		{
+		case 0: return Policy->GetEncoderNetworkAsset();
+		case 1: return Policy->GetPolicyNetworkAsset();
+		default: return Policy->GetDecoderNetworkAsset();
+		}
+	}
+}
+
+FCapStonePolicyHotSwap::~FCapStonePolicyHotSwap()
+{
+	Flush();
+}
+
+void FCapStonePolicyHotSwap::Init(ULearningAgentsPolicy* InPolicy, const FString& InWatchDirectory, const FSnapshotNames& InNames, float InPollInterval)
+{
+	Flush();
+
+	Policy = InPolicy;
+	WatchDirectory = InWatchDirectory;
+	Names = InNames;
+	PollInterval = FMath::Max(InPollInterval, 0.1f);
+	PollTimer = 0.f;
+
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		const ULearningAgentsNeuralNetwork* Network = Policy ? GetNetworkAsset(Policy, Index) : nullptr;
+		ExpectedByteNum[Index] = Network && Network->NeuralNetworkData ? Network->NeuralNetworkData->GetSnapshotByteNum() : 0;
+	}
+
+	// 시작할 때 이미 있던 파일은 BeginPlay 에서 읽은 것으로 본다
+	LastLoadedTimeStamp = FDateTime::UtcNow();
+
+	if (!WatchDirectory.IsEmpty())
+	{
+		UE_LOG(LogTemp, Log, TEXT("Watching %s for policy snapshots (%s, %s, %s)."),
+			*WatchDirectory, *Names.Encoder, *Names.Policy, *Names.Decoder);
+	}
+}
+
+void FCapStonePolicyHotSwap::RequestLoad(const FString& EncoderPath, const FString& PolicyPath, const FString& DecoderPath)
+{
+	RequestPaths[0] = EncoderPath;
+	RequestPaths[1] = PolicyPath;
+	RequestPaths[2] = DecoderPath;
+	bHasRequest = true;
+}
+
+void FCapStonePolicyHotSwap::Flush()
+{
+	if (LoadTask.IsValid())
+	{
+		LoadTask.Wait();
+		LoadTask = UE::Tasks::TTask<TSharedPtr<FLoadResult>>();
+	}
+}
+
+bool FCapStonePolicyHotSwap::PollDirectory()
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	FDateTime Newest = FDateTime::MinValue();
+	FDateTime Oldest = FDateTime::MaxValue();
+	for (const FString* Name : { &Names.Encoder, &Names.Policy, &Names.Decoder })
+	{
+		const FDateTime TimeStamp = FileManager.GetTimeStamp(*(WatchDirectory / *Name));
+		if (TimeStamp == FDateTime::MinValue())
+		{
+			return false;
+		}
+		Newest = FMath::Max(Newest, TimeStamp);
+		Oldest = FMath::Min(Oldest, TimeStamp);
+	}
+
+	// 세 파일이 모두 마지막 로드 이후에 쓰였고, 쓰기가 끝난 뒤 조금 지났을 때만
+	if (Oldest <= LastLoadedTimeStamp || FDateTime::UtcNow() - Newest < FTimespan::FromSeconds(SettleSeconds))
+	{
+		return false;
+	}
+
+	LastLoadedTimeStamp = Newest;
+	RequestLoad(WatchDirectory / Names.Encoder, WatchDirectory / Names.Policy, WatchDirectory / Names.Decoder);
+	return true;
+}
+
+void FCapStonePolicyHotSwap::Tick(float DeltaSeconds)
+{
+	if (!Policy || LoadTask.IsValid())
+	{
+		return;
+	}
+
+	if (!bHasRequest && !WatchDirectory.IsEmpty())
+	{
+		PollTimer += DeltaSeconds;
+		if (PollTimer >= PollInterval)
+		{
+			PollTimer = 0.f;
+			PollDirectory();
+		}
+	}
+
+	if (bHasRequest)
+	{
+		bHasRequest = false;
+		LaunchLoad(RequestPaths);
+	}
+}
+
+void FCapStonePolicyHotSwap::LaunchLoad(const FString (&Paths)[3])
+{
+	TArray<FString> TaskPaths = { Paths[0], Paths[1], Paths[2] };
+	TArray<int64> TaskByteNum = { ExpectedByteNum[0], ExpectedByteNum[1], ExpectedByteNum[2] };
+
+	LoadTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [TaskPaths = MoveTemp(TaskPaths), TaskByteNum = MoveTemp(TaskByteNum)]()
+	{
+		TSharedPtr<FLoadResult> Result = MakeShared<FLoadResult>();
+		Result->Source = FPaths::GetPath(TaskPaths[1]);
+
+		for (int32 Index = 0; Index < 3; ++Index)
+		{
+			if (!FFileHelper::LoadFileToArray(Result->Bytes[Index], *TaskPaths[Index]))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Policy snapshot %s could not be read."), *TaskPaths[Index]);
+				return Result;
+			}
+
+			// 구조가 다른 network 의 snapshot 은 크기가 다르다
+			if (Result->Bytes[Index].Num() != TaskByteNum[Index])
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Policy snapshot %s is %d bytes, expected %lld."),
+					*TaskPaths[Index], Result->Bytes[Index].Num(), TaskByteNum[Index]);
+				return Result;
+			}
+		}
+
+		Result->bValid = true;
+		return Result;
+	});
+}
+
+bool FCapStonePolicyHotSwap::TryApply()
+{
+	if (!Policy || !LoadTask.IsValid() || !LoadTask.IsCompleted())
+	{
+		return false;
+	}
+
+	const TSharedPtr<FLoadResult> Result = LoadTask.GetResult();
+	LoadTask = UE::Tasks::TTask<TSharedPtr<FLoadResult>>();
+
+	if (!Result.IsValid() || !Result->bValid)
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		const ULearningNeuralNetworkData* NetworkData = GetNetworkAsset(Policy, Index)->NeuralNetworkData;
+		PreviousBytes[Index].SetNumUninitialized(NetworkData->GetSnapshotByteNum());
+		NetworkData->SaveToSnapshot(PreviousBytes[Index]);
+	}
+
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		if (!GetNetworkAsset(Policy, Index)->NeuralNetworkData->LoadFromSnapshot(Result->Bytes[Index]))
+		{
+			// 앞의 network 만 새 가중치로 남지 않도록 세 network 모두 swap 전으로 되돌린다
+			UE_LOG(LogTemp, Error, TEXT("Policy snapshot swap from %s failed on network %d, keeping snapshot %d."),
+				*Result->Source, Index, Version);
+			for (int32 RollbackIndex = 0; RollbackIndex < 3; ++RollbackIndex)
+			{
+				if (!GetNetworkAsset(Policy, RollbackIndex)->NeuralNetworkData->LoadFromSnapshot(PreviousBytes[RollbackIndex]))
+				{
+					UE_LOG(LogTemp, Error, TEXT("Policy snapshot rollback failed on network %d."), RollbackIndex);
+				}
+			}
+			return false;
+		}
+	}
+
+	++Version;
+	UE_LOG(LogTemp, Log, TEXT("Swapped in policy snapshot %d from %s."), Version, *Result->Source);
+	return true;
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Tasks/Task.h"
+
+class ULearningAgentsPolicy;
+
+/**
+ * 실행 중인 inference policy 의 encoder, policy, decoder 가중치를 재시작 없이 바꾼다.
+ *
+ * 파일 읽기와 크기 검사는 worker task 에서 하고, 세 network 가 모두 준비되면
+ * AMyLearningManager 가 스텝 경계에서 TryApply() 로 한 번에 바꾼다. 하나라도 실패하면 세 network 모두 이전 가중치로 되돌린다.
+ * WatchDirectory 가 있으면 그 안의 세 snapshot 파일이 모두 새로 쓰이고 SettleSeconds 동안 바뀌지 않을 때 읽는다.
+ */
+class CAPSTONE_API FCapStonePolicyHotSwap
+{
+public:
+	/** File names of the three snapshots inside WatchDirectory */
+	struct FSnapshotNames
+	{
+		FString Encoder = TEXT("encoder.bin");
+		FString Policy = TEXT("policy.bin");
+		FString Decoder = TEXT("decoder.bin");
+	};
+
+	~FCapStonePolicyHotSwap();
+
+	void Init(ULearningAgentsPolicy* InPolicy, const FString& InWatchDirectory, const FSnapshotNames& InNames, float InPollInterval);
+
+	/** Queues a load of three snapshot files. Replaces a request that has not started yet. */
+	void RequestLoad(const FString& EncoderPath, const FString& PolicyPath, const FString& DecoderPath);
+
+	/** Game thread, once per frame. Polls the directory and launches the load task. */
+	void Tick(float DeltaSeconds);
+
+	/** Game thread, at a step boundary while nothing is evaluating the networks. Returns true when new weights were swapped in. */
+	bool TryApply();
+
+	void Flush();
+
+	int32 GetVersion() const { return Version; }
+
+private:
+	struct FLoadResult
+	{
+		FString Source;
+		TArray<uint8> Bytes[3];
+		bool bValid = false;
+	};
+
+	void LaunchLoad(const FString (&Paths)[3]);
+	bool PollDirectory();
+
+	ULearningAgentsPolicy* Policy = nullptr;
+
+	FString WatchDirectory;
+	FSnapshotNames Names;
+	float PollInterval = 2.f;
+	float PollTimer = 0.f;
+	// 파일이 다 쓰였다고 볼 때까지 기다리는 시간
+	double SettleSeconds = 1.0;
+	FDateTime LastLoadedTimeStamp = FDateTime::MinValue();
+
+	// 각 network 의 GetSnapshotByteNum, Init 에서 game thread 가 읽어 둔다
+	int64 ExpectedByteNum[3] = {};
+
+	bool bHasRequest = false;
+	FString RequestPaths[3];
+
+	// swap 직전의 세 network 가중치. 중간에 LoadFromSnapshot 이 실패하면 이것으로 되돌린다
+	TArray<uint8> PreviousBytes[3];
+
+	UE::Tasks::TTask<TSharedPtr<FLoadResult>> LoadTask;
+	int32 Version = 0;
+};
@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneRLStats.h"
+
+#include "Engine/World.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+
+DEFINE_STAT(STAT_CapStoneRL_Step);
+DEFINE_STAT(STAT_CapStoneRL_RunTraining);
+DEFINE_STAT(STAT_CapStoneRL_GatherObservations);
+DEFINE_STAT(STAT_CapStoneRL_PerformActions);
+DEFINE_STAT(STAT_CapStoneRL_GatherRewards);
+DEFINE_STAT(STAT_CapStoneRL_GatherCompletions);
+DEFINE_STAT(STAT_CapStoneRL_ResetEpisodes);
+DEFINE_STAT(STAT_CapStoneRL_Trainer);
+DEFINE_STAT(STAT_CapStoneRL_Physics);
+DEFINE_STAT(STAT_CapStoneRL_ProcessExperience);
+
+CSV_DEFINE_CATEGORY_MODULE(CAPSTONE_API, CapStoneRL, true);
+
+UE_TRACE_CHANNEL_DEFINE(CapStoneRLChannel);
+
+UE_TRACE_EVENT_BEGIN(CapStoneRL, AgentDecision)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(int32, AgentId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CapStoneRL, AgentReward)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(int32, AgentId)
+	UE_TRACE_EVENT_FIELD(float, Reward)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CapStoneRL, EpisodeEnd)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(int32, AgentId)
+	UE_TRACE_EVENT_FIELD(uint8, Completion)
+UE_TRACE_EVENT_END()
+
+namespace CapStoneRLTrace
+{
+	void AgentDecision(int32 AgentId)
+	{
+		UE_TRACE_LOG(CapStoneRL, AgentDecision, CapStoneRLChannel)
+			<< AgentDecision.Cycle(FPlatformTime::Cycles64())
+			<< AgentDecision.AgentId(AgentId);
+	}
+
+	void AgentReward(int32 AgentId, float Reward)
+	{
+		UE_TRACE_LOG(CapStoneRL, AgentReward, CapStoneRLChannel)
+			<< AgentReward.Cycle(FPlatformTime::Cycles64())
+			<< AgentReward.AgentId(AgentId)
+			<< AgentReward.Reward(Reward);
+	}
+
+	void EpisodeEnd(int32 AgentId, uint8 Completion)
+	{
+		UE_TRACE_LOG(CapStoneRL, EpisodeEnd, CapStoneRLChannel)
+			<< EpisodeEnd.Cycle(FPlatformTime::Cycles64())
+			<< EpisodeEnd.AgentId(AgentId)
+			<< EpisodeEnd.Completion(Completion);
+	}
+}
+
+namespace
+{
+	// 월드별 physics scene delegate
+	TMap<FPhysScene*, TPair<FDelegateHandle, FDelegateHandle>> PhysicsSceneHandles;
+}
+
+FCapStoneRLProfiler& FCapStoneRLProfiler::Get()
+{
+	static FCapStoneRLProfiler Profiler;
+	return Profiler;
+}
+
+const TCHAR* FCapStoneRLProfiler::GetPhaseName(ECapStoneRLPhase Phase)
+{
+	switch (Phase)
+	{
+	case ECapStoneRLPhase::Step: return TEXT("Step");
+	case ECapStoneRLPhase::RunTraining: return TEXT("RunTraining");
+	case ECapStoneRLPhase::GatherObservations: return TEXT("GatherObservations");
+	case ECapStoneRLPhase::PerformActions: return TEXT("PerformActions");
+	case ECapStoneRLPhase::GatherRewards: return TEXT("GatherRewards");
+	case ECapStoneRLPhase::GatherCompletions: return TEXT("GatherCompletions");
+	case ECapStoneRLPhase::ResetEpisodes: return TEXT("ResetEpisodes");
+	case ECapStoneRLPhase::Trainer: return TEXT("Trainer");
+	case ECapStoneRLPhase::Physics: return TEXT("Physics");
+	case ECapStoneRLPhase::ProcessExperience: return TEXT("ProcessExperience");
+	default: return TEXT("Unknown");
+	}
+}
+
+void FCapStoneRLProfiler::SetLogInterval(int32 InLogInterval)
+{
+	LogInterval = FMath::Max(InLogInterval, 0);
+	for (TArray<float>& PhaseHistory : History)
+	{
+		PhaseHistory.Reset(LogInterval);
+	}
+	WindowStartTime = FPlatformTime::Seconds();
+}
+
+void FCapStoneRLProfiler::BeginStep()
+{
+	FMemory::Memzero(CurrentStep);
+	CurrentNestedInTrainer = 0.0;
+}
+
+void FCapStoneRLProfiler::EndStep()
+{
+	// 지난 EndStep 이후 끝난 physics tick
+	CurrentStep[(int32)ECapStoneRLPhase::Physics] += PendingPhysicsSeconds;
+	PendingPhysicsSeconds = 0.0;
+
+	// RunTraining 안에서 env, interactor 가 쓴 시간을 빼면 trainer 통신과 network 평가 시간이 남는다
+	const double TrainerSeconds = FMath::Max(CurrentStep[(int32)ECapStoneRLPhase::RunTraining] - CurrentNestedInTrainer, 0.0);
+	CurrentStep[(int32)ECapStoneRLPhase::Trainer] = TrainerSeconds;
+
+	SET_CYCLE_COUNTER(STAT_CapStoneRL_Trainer, (uint32)(TrainerSeconds / FPlatformTime::GetSecondsPerCycle()));
+	CSV_CUSTOM_STAT(CapStoneRL, TrainerMs, (float)(TrainerSeconds * 1000.0), ECsvCustomStatOp::Set);
+
+	if (LogInterval <= 0)
+	{
+		return;
+	}
+
+	for (int32 Phase = 0; Phase < PhaseNum; ++Phase)
+	{
+		History[Phase].Add((float)(CurrentStep[Phase] * 1000.0));
+	}
+
+	if (History[0].Num() >= LogInterval)
+	{
+		LogAndReset();
+	}
+}
+
+void FCapStoneRLProfiler::AddPhaseTime(ECapStoneRLPhase Phase, double Seconds)
+{
+	CurrentStep[(int32)Phase] += Seconds;
+
+	if (TrainerDepth > 0 && Phase != ECapStoneRLPhase::RunTraining)
+	{
+		CurrentNestedInTrainer += Seconds;
+	}
+}
+
+void FCapStoneRLProfiler::BindPhysicsScene(UWorld* World)
+{
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+	if (!PhysScene || PhysicsSceneHandles.Contains(PhysScene))
+	{
+		return;
+	}
+
+	FDelegateHandle PreTick = PhysScene->OnPhysScenePreTick.AddLambda([this](FPhysScene*, float)
+	{
+		PhysicsStartCycles = FPlatformTime::Cycles64();
+	});
+	FDelegateHandle PostTick = PhysScene->OnPhysScenePostTick.AddLambda([this](FChaosScene*)
+	{
+		if (PhysicsStartCycles == 0)
+		{
+			return;
+		}
+
+		const uint64 Cycles = FPlatformTime::Cycles64() - PhysicsStartCycles;
+		PhysicsStartCycles = 0;
+
+		SET_CYCLE_COUNTER(STAT_CapStoneRL_Physics, (uint32)Cycles);
+		CSV_CUSTOM_STAT(CapStoneRL, PhysicsMs, (float)(FPlatformTime::ToMilliseconds64(Cycles)), ECsvCustomStatOp::Set);
+		PendingPhysicsSeconds += FPlatformTime::ToSeconds64(Cycles);
+	});
+
+	PhysicsSceneHandles.Add(PhysScene, TPair<FDelegateHandle, FDelegateHandle>(PreTick, PostTick));
+}
+
+void FCapStoneRLProfiler::UnbindPhysicsScene(UWorld* World)
+{
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+	TPair<FDelegateHandle, FDelegateHandle> Handles;
+	if (!PhysScene || !PhysicsSceneHandles.RemoveAndCopyValue(PhysScene, Handles))
+	{
+		return;
+	}
+
+	PhysScene->OnPhysScenePreTick.Remove(Handles.Key);
+	PhysScene->OnPhysScenePostTick.Remove(Handles.Value);
+}
+
+void FCapStoneRLProfiler::LogAndReset()
+{
+	const double Now = FPlatformTime::Seconds();
+	const double Elapsed = FMath::Max(Now - WindowStartTime, UE_DOUBLE_SMALL_NUMBER);
+	const int32 StepNum = History[0].Num();
+
+	UE_LOG(LogTemp, Log, TEXT("CapStoneRL: %d steps, %.1f steps/sec"), StepNum, StepNum / Elapsed);
+
+	for (int32 Phase = 0; Phase < PhaseNum; ++Phase)
+	{
+		TArray<float>& PhaseHistory = History[Phase];
+		PhaseHistory.Sort();
+
+		auto Percentile = [&PhaseHistory](float P)
+		{
+			return PhaseHistory[FMath::Clamp(FMath::FloorToInt32(P * (PhaseHistory.Num() - 1)), 0, PhaseHistory.Num() - 1)];
+		};
+
+		UE_LOG(LogTemp, Log, TEXT("  %-20s p50 %7.3f ms  p95 %7.3f ms  p99 %7.3f ms  max %7.3f ms"),
+			GetPhaseName((ECapStoneRLPhase)Phase), Percentile(0.5f), Percentile(0.95f), Percentile(0.99f), PhaseHistory.Last());
+
+		PhaseHistory.Reset();
+	}
+
+	WindowStartTime = Now;
+}
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+// stat CapStoneRL
+DECLARE_STATS_GROUP(TEXT("CapStoneRL"), STATGROUP_CapStoneRL, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Step"), STAT_CapStoneRL_Step, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RunTraining / RunInference"), STAT_CapStoneRL_RunTraining, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gather Observations"), STAT_CapStoneRL_GatherObservations, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Perform Actions"), STAT_CapStoneRL_PerformActions, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gather Rewards"), STAT_CapStoneRL_GatherRewards, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Gather Completions"), STAT_CapStoneRL_GatherCompletions, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Reset Episodes"), STAT_CapStoneRL_ResetEpisodes, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Trainer / Inference"), STAT_CapStoneRL_Trainer, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics"), STAT_CapStoneRL_Physics, STATGROUP_CapStoneRL, CAPSTONE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Experience"), STAT_CapStoneRL_ProcessExperience, STATGROUP_CapStoneRL, CAPSTONE_API);
+
+// -csvCategories=CapStoneRL
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(CAPSTONE_API, CapStoneRL);
+
+// -trace=cpu,CapStoneRL
+UE_TRACE_CHANNEL_EXTERN(CapStoneRLChannel, CAPSTONE_API);
+
+/** Timed phases of one RL step. Trainer is derived: RunTraining minus the phases nested in it. */
+enum class ECapStoneRLPhase : uint8
+{
+	Step,
+	RunTraining,
+	GatherObservations,
+	PerformActions,
+	GatherRewards,
+	GatherCompletions,
+	ResetEpisodes,
+	Trainer,
+	Physics,
+	// Pipelined training: ProcessExperience on the game thread while physics simulates
+	ProcessExperience,
+	Num,
+};
+
+/**
+ * 스텝별 phase 시간을 모아 두었다가 N 스텝마다 steps/sec 와 phase 별 percentile 을 로그로 남긴다.
+ * Game thread 에서만 쓴다.
+ */
+class CAPSTONE_API FCapStoneRLProfiler
+{
+public:
+	static FCapStoneRLProfiler& Get();
+
+	/** 0 turns the rolling log off */
+	void SetLogInterval(int32 InLogInterval);
+
+	void BeginStep();
+	void EndStep();
+
+	void AddPhaseTime(ECapStoneRLPhase Phase, double Seconds);
+
+	void EnterTrainer() { ++TrainerDepth; }
+	void ExitTrainer() { --TrainerDepth; }
+
+	/**
+	 * Physics 는 FPhysScene pre/post tick 사이 시간으로 잰다.
+	 * Post tick 은 보통 EndStep 뒤에 오므로 모아 두었다가 다음 EndStep 에서 그 스텝에 더한다.
+	 */
+	void BindPhysicsScene(UWorld* World);
+	void UnbindPhysicsScene(UWorld* World);
+
+	static const TCHAR* GetPhaseName(ECapStoneRLPhase Phase);
+
+private:
+	void LogAndReset();
+
+	static constexpr int32 PhaseNum = (int32)ECapStoneRLPhase::Num;
+
+	int32 LogInterval = 0;
+	int32 TrainerDepth = 0;
+
+	double CurrentStep[PhaseNum] = {};
+	double CurrentNestedInTrainer = 0.0;
+
+	// Phase 별로 LogInterval 개의 스텝 시간 (ms)
+	TArray<float> History[PhaseNum];
+
+	double WindowStartTime = 0.0;
+	uint64 PhysicsStartCycles = 0;
+
+	// BeginStep 의 Memzero 에 지워지지 않도록 CurrentStep 밖에 모은다
+	double PendingPhysicsSeconds = 0.0;
+};
+
+/** Adds the scope's time to one phase of the rolling profiler */
+struct FCapStoneRLPhaseScope
+{
+	explicit FCapStoneRLPhaseScope(ECapStoneRLPhase InPhase)
+		: Phase(InPhase)
+		, StartCycles(FPlatformTime::Cycles64())
+	{
+		if (Phase == ECapStoneRLPhase::RunTraining)
+		{
+			FCapStoneRLProfiler::Get().EnterTrainer();
+		}
+	}
+
+	~FCapStoneRLPhaseScope()
+	{
+		if (Phase == ECapStoneRLPhase::RunTraining)
+		{
+			FCapStoneRLProfiler::Get().ExitTrainer();
+		}
+		FCapStoneRLProfiler::Get().AddPhaseTime(Phase, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+	}
+
+	ECapStoneRLPhase Phase;
+	uint64 StartCycles;
+};
+
+/** stat CapStoneRL, CSV, Insights 와 rolling profiler 에 같이 기록되는 scope */
+#define CAPSTONE_RL_SCOPE(Phase) \
+	SCOPE_CYCLE_COUNTER(STAT_CapStoneRL_##Phase); \
+	CSV_SCOPED_TIMING_STAT(CapStoneRL, Phase); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("CapStoneRL::" #Phase, CapStoneRLChannel); \
+	FCapStoneRLPhaseScope CapStoneRLPhaseScope_##Phase(ECapStoneRLPhase::Phase)
+
+/** Per-agent Insights events on CapStoneRLChannel */
+namespace CapStoneRLTrace
+{
+	CAPSTONE_API void AgentDecision(int32 AgentId);
+	CAPSTONE_API void AgentReward(int32 AgentId, float Reward);
+	CAPSTONE_API void EpisodeEnd(int32 AgentId, uint8 Completion);
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CapStoneRewardEvaluator.h"
+
+#include "CapStoneAgentSnapshot.h"
+#include "LearningAgentsRewards.h"
+#include "Async/ParallelFor.h"
+
+void FCapStoneRewardEvaluator::Evaluate(const FCapStoneAgentSnapshot& Snapshot, TConstArrayView<int32> AgentIds)
+{
+	const int32 MaxAgentNum = Snapshot.GetMaxAgentNum();
+	Rewards.SetNumZeroed(MaxAgentNum);
+	Completions.SetNum(MaxAgentNum);
+
+	// AgentId 마다 쓰는 자리가 달라서 lock 없이 나눠 돌릴 수 있다
+	ParallelFor(AgentIds.Num(), [this, &Snapshot, AgentIds](int32 Index)
+	{
+		const int32 AgentId = AgentIds[Index];
+		if (Rewards.IsValidIndex(AgentId))
+		{
+			EvaluateAgent(Snapshot, AgentId, Rewards[AgentId], Completions[AgentId]);
+		}
+	}, AgentIds.Num() < ParallelAgentNum ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+void FCapStoneRewardEvaluator::EvaluateAgent(const FCapStoneAgentSnapshot& Snapshot, int32 AgentId,
+	float& OutReward, ELearningAgentsCompletion& OutCompletion)
+{
+	OutReward = 0.f;
+	OutCompletion = ELearningAgentsCompletion::Running;
+
+	if (!Snapshot.IsValid(AgentId) || Snapshot.EnemyNum[AgentId] <= 0)
+	{
+		return;
+	}
+
+	const FVector& Location = Snapshot.Location[AgentId];
+	const float MaxDistanceSquared = FMath::Square(Snapshot.MaxEnemyDistance[AgentId]);
+	const int32 First = FCapStoneAgentSnapshot::EnemyIndex(AgentId, 0);
+	const int32 Last = First + Snapshot.EnemyNum[AgentId];
+
+	// 적은 가까운 순서라서 범위를 벗어나는 첫 적에서 멈춘다
+	int32 InRangeEnd = First;
+	while (InRangeEnd < Last && FVector::DistSquared(Location, Snapshot.EnemyLocation[InRangeEnd]) <= MaxDistanceSquared)
+	{
+		++InRangeEnd;
+	}
+	const bool bAnyInRange = InRangeEnd > First;
+	const int32 End = bAnyInRange ? InRangeEnd : First + 1;
+
+	float DistanceReward = 0.f;
+	float EnemyDeadReward = 0.f;
+	float EnemyHealthRatio = 0.f;
+	bool bAllEnemiesDead = true;
+
+	for (int32 Enemy = First; Enemy < End; ++Enemy)
+	{
+		DistanceReward = FMath::Max(DistanceReward, ULearningAgentsRewards::MakeRewardFromLocationSimilarity(
+			Location, Snapshot.EnemyLocation[Enemy], 100.0f, 1.0f));
+
+		EnemyDeadReward += ULearningAgentsRewards::MakeRewardOnCondition(Snapshot.EnemyDead[Enemy], 100.0f);
+		EnemyHealthRatio += 1 - Snapshot.EnemyHealth[Enemy] / Snapshot.EnemyMaxHealth[Enemy];
+		bAllEnemiesDead &= Snapshot.EnemyDead[Enemy];
+	}
+	EnemyHealthRatio /= End - First;
+
+	// 적 타격 reward
+	const float HitReward = ULearningAgentsRewards::MakeRewardOnCondition(Snapshot.Hit[AgentId], 10.0f);
+
+	// custom 조절 reward
+	const float EnemyHealthReward = ULearningAgentsRewards::MakeReward(
+		EnemyHealthRatio, Snapshot.EnemyHealthRewardScale[AgentId]);
+	const float MyHealthReward = ULearningAgentsRewards::MakeReward(
+		Snapshot.Health[AgentId] / Snapshot.MaxHealth[AgentId], Snapshot.MyHealthRewardScale[AgentId]);
+	const float StaminaReward = ULearningAgentsRewards::MakeReward(
+		Snapshot.Stamina[AgentId] / Snapshot.MaxStamina[AgentId], Snapshot.StaminaRewardScale[AgentId]);
+
+	OutReward = DistanceReward + EnemyDeadReward + HitReward + EnemyHealthReward + MyHealthReward + StaminaReward;
+
+	const bool bStaminaOver = Snapshot.Stamina[AgentId] > Snapshot.MaxStamina[AgentId];
+	if (bAllEnemiesDead || bStaminaOver || !bAnyInRange)
+	{
+		OutCompletion = ELearningAgentsCompletion::Termination;
+	}
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LearningAgentsCompletions.h"
+
+struct FCapStoneAgentSnapshot;
+
+/**
+ * 모든 agent 의 reward 와 completion 을 스냅샷 배열에서 한 번에 계산한다.
+ * 적은 MaxEnemyDistance 안에 있는 것을 모두 본다. 범위 안에 아무도 없으면 가장 가까운 적 하나만 본다.
+ *  - 거리 reward: 범위 안에서 가장 큰 location similarity
+ *  - 적 죽음 reward: 범위 안의 죽은 적마다 더한다
+ *  - 적 체력 reward: 범위 안 적들의 (1 - 체력 비율) 평균
+ *  - 적 죽음 completion: 범위 안의 적이 모두 죽었을 때
+ *  - 거리 completion: 범위 안에 적이 하나도 없을 때
+ * 적이 하나뿐이면 예전 agent 별 계산과 같은 값이 나온다.
+ */
+struct CAPSTONE_API FCapStoneRewardEvaluator
+{
+	/** Below this many agents the pass stays on the calling thread */
+	static constexpr int32 ParallelAgentNum = 64;
+
+	/** Fills the AgentId-indexed reward and completion arrays for AgentIds */
+	void Evaluate(const FCapStoneAgentSnapshot& Snapshot, TConstArrayView<int32> AgentIds);
+
+	/** Reward and completion of one agent, computed from the snapshot */
+	static void EvaluateAgent(const FCapStoneAgentSnapshot& Snapshot, int32 AgentId,
+		float& OutReward, ELearningAgentsCompletion& OutCompletion);
+
+	float GetReward(int32 AgentId) const { return Rewards.IsValidIndex(AgentId) ? Rewards[AgentId] : 0.f; }
+
+	ELearningAgentsCompletion GetCompletion(int32 AgentId) const
+	{
+		return Completions.IsValidIndex(AgentId) ? Completions[AgentId] : ELearningAgentsCompletion::Running;
+	}
+
+private:
+	TArray<float> Rewards;
+	TArray<ELearningAgentsCompletion> Completions;
+};
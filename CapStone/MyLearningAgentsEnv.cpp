@@ -3,7 +3,7 @@
 #include "MyLearningAgentsEnv.h"
 
 #include "CapStoneCharacter.h"
-#include "LearningAgentsRewards.h"
+#include "CapStoneRLStats.h"
 #include "LearningAgentsCompletions.h"
 #include "LearningAgentsManagerListener.h"
 
@@ -12,48 +12,10 @@ void UMyLearningAgentsEnv::GatherAgentReward_Implementation(
     float& OutReward, const int32 AgentId
 )
 {
-    UObject* RewardActor = ULearningAgentsManagerListener::GetAgent(AgentId);
-    ACapStoneCharacter* RewardCharacter = Cast<ACapStoneCharacter>(RewardActor);
-    if (RewardCharacter)
+    if (AgentSnapshot)
     {
-        // 기본 reward
-        // 적과의 거리 reward
-        FVector MyLocation = RewardCharacter->GetActorLocation();
-        const TArray<FVector>& EnemyLocations = RewardCharacter->GetEnemyLocation();
-        if(EnemyLocations.Num() <= 0)
-        {
-            return;
-        }
-        float DistanceReward = ULearningAgentsRewards::MakeRewardFromLocationSimilarity(
-            MyLocation, EnemyLocations[0], 100.0f, 1.0f);
-
-        // 적 죽음 reward
-        const TArray<ACapStoneCharacter*>& Enemies = RewardCharacter->GetEnemyCharacters();
-        if(Enemies.Num() <= 0)
-        {
-            return;
-        }
-        float EnemyDeadReward = ULearningAgentsRewards::MakeRewardOnCondition(
-            Enemies[0]->GetIsDead(), 100.0f);
-        // 적 타격 reward
-        float HitReward = ULearningAgentsRewards::MakeRewardOnCondition(
-            RewardCharacter->IsHit(), 10.0f);
-
-        // custom 조절 reward
-        float EnemyHealthReward = ULearningAgentsRewards::MakeReward(
-            1-Enemies[0]->GetHealth()/Enemies[0]->GetMaxHealth(),
-            RewardCharacter->GetEHRScale() 
-        );
-        float MyHealthReward = ULearningAgentsRewards::MakeReward(
-            RewardCharacter->GetHealth()/RewardCharacter->GetMaxHealth(),
-            RewardCharacter->GetMHRScale()
-        );
-        float StaminaReward = ULearningAgentsRewards::MakeReward(
-            RewardCharacter->GetStamina()/RewardCharacter->GetMaxStamina(),
-            RewardCharacter->GetSRScale()
-        );
-    
-        OutReward = DistanceReward + EnemyDeadReward + HitReward + EnemyHealthReward + MyHealthReward + StaminaReward;
+        ELearningAgentsCompletion Completion;
+        FCapStoneRewardEvaluator::EvaluateAgent(*AgentSnapshot, AgentId, OutReward, Completion);
     }
 }
 
@@ -61,41 +23,115 @@ void UMyLearningAgentsEnv::GatherAgentCompletion_Implementation(
     ELearningAgentsCompletion& OutCompletion, const int32 AgentId
 )
 {
-    UObject* CompletionActor = ULearningAgentsManagerListener::GetAgent(AgentId);
-    ACapStoneCharacter* CompletionCharacter = Cast<ACapStoneCharacter>(CompletionActor);
-    if (CompletionCharacter)
+    if (AgentSnapshot)
     {
-        const TArray<ACapStoneCharacter*>& Enemies = CompletionCharacter->GetEnemyCharacters();
-        if(Enemies.Num() <= 0)
+        float Reward;
+        FCapStoneRewardEvaluator::EvaluateAgent(*AgentSnapshot, AgentId, Reward, OutCompletion);
+    }
+}
+
+void UMyLearningAgentsEnv::GatherAgentRewards_Implementation(
+    TArray<float>& OutRewards, const TArray<int32>& AgentIds
+)
+{
+    CAPSTONE_RL_SCOPE(GatherRewards);
+
+    const int32 MaxAgentNum = AgentSnapshot ? AgentSnapshot->GetMaxAgentNum() : 0;
+    LastRewards.SetNum(MaxAgentNum);
+    HasRewardOutcome.SetNum(MaxAgentNum, false);
+
+    EnsureEvaluated(AgentIds);
+
+    OutRewards.SetNumUninitialized(AgentIds.Num());
+    for (int32 Index = 0; Index < AgentIds.Num(); ++Index)
+    {
+        OutRewards[Index] = RewardEvaluator.GetReward(AgentIds[Index]);
+        CapStoneRLTrace::AgentReward(AgentIds[Index], OutRewards[Index]);
+
+        if (LastRewards.IsValidIndex(AgentIds[Index]))
         {
-            return;
+            LastRewards[AgentIds[Index]] = OutRewards[Index];
+            HasRewardOutcome[AgentIds[Index]] = true;
         }
-        ELearningAgentsCompletion DeadCompletion = 
-        ULearningAgentsCompletions::MakeCompletionOnCondition(Enemies[0]->GetIsDead());
+    }
+}
+
+void UMyLearningAgentsEnv::GatherAgentCompletions_Implementation(
+    TArray<ELearningAgentsCompletion>& OutCompletions, const TArray<int32>& AgentIds
+)
+{
+    CAPSTONE_RL_SCOPE(GatherCompletions);
+
+    EnsureEvaluated(AgentIds);
+
+    if (Curriculum && AgentSnapshot)
+    {
+        Curriculum->RecordStep(*AgentSnapshot, AgentIds);
+    }
 
-        bool IsStaminaOver = 
-        CompletionCharacter->GetStamina() > CompletionCharacter->GetMaxStamina();
-        ELearningAgentsCompletion StaminaCompletion =
-        ULearningAgentsCompletions::MakeCompletionOnCondition(IsStaminaOver);
+    const int32 MaxAgentNum = AgentSnapshot ? AgentSnapshot->GetMaxAgentNum() : 0;
+    LastCompletions.SetNum(MaxAgentNum);
+    HasCompletionOutcome.SetNum(MaxAgentNum, false);
+
+    OutCompletions.SetNumUninitialized(AgentIds.Num());
+    for (int32 Index = 0; Index < AgentIds.Num(); ++Index)
+    {
+        OutCompletions[Index] = RewardEvaluator.GetCompletion(AgentIds[Index]);
+
+        if (OutCompletions[Index] != ELearningAgentsCompletion::Running)
+        {
+            CapStoneRLTrace::EpisodeEnd(AgentIds[Index], (uint8)OutCompletions[Index]);
+        }
 
-        FVector MyLocation = CompletionCharacter->GetActorLocation();
-        const TArray<FVector>& EnemyLocations = CompletionCharacter->GetEnemyLocation();
-        if(EnemyLocations.Num() <= 0)
+        if (LastCompletions.IsValidIndex(AgentIds[Index]))
         {
-            return;
+            LastCompletions[AgentIds[Index]] = OutCompletions[Index];
+            HasCompletionOutcome[AgentIds[Index]] = true;
         }
-        ELearningAgentsCompletion DistanceCompletion = 
-        ULearningAgentsCompletions::MakeCompletionOnLocationDifferenceAboveThreshold(
-            MyLocation, EnemyLocations[0], CompletionCharacter->GetMaxEnemyDistance());
-
-        OutCompletion = 
-        ULearningAgentsCompletions::CompletionOr(
-            ULearningAgentsCompletions::CompletionOr(
-                DeadCompletion, StaminaCompletion), DistanceCompletion);
-        
     }
 }
 
+void UMyLearningAgentsEnv::EnsureEvaluated(
+    const TArray<int32>& AgentIds
+)
+{
+    if (!AgentSnapshot)
+    {
+        return;
+    }
+
+    // trainer 는 completion 을 reward 보다 먼저 모은다. 같은 스냅샷이면 두 번째 호출은 앞의 결과를 쓴다
+    if (bHasEvaluation && EvaluatedVersion == AgentSnapshot->GetVersion())
+    {
+        return;
+    }
+
+    RewardEvaluator.Evaluate(*AgentSnapshot, AgentIds);
+    EvaluatedVersion = AgentSnapshot->GetVersion();
+    bHasEvaluation = true;
+}
+
+bool UMyLearningAgentsEnv::ConsumeAgentOutcome(
+    const int32 AgentId, float& OutReward, ELearningAgentsCompletion& OutCompletion
+)
+{
+    if (!HasRewardOutcome.IsValidIndex(AgentId) || !HasRewardOutcome[AgentId])
+    {
+        return false;
+    }
+
+    OutReward = LastRewards[AgentId];
+    OutCompletion = HasCompletionOutcome.IsValidIndex(AgentId) && HasCompletionOutcome[AgentId] ?
+        LastCompletions[AgentId] : ELearningAgentsCompletion::Running;
+
+    HasRewardOutcome[AgentId] = false;
+    if (HasCompletionOutcome.IsValidIndex(AgentId))
+    {
+        HasCompletionOutcome[AgentId] = false;
+    }
+    return true;
+}
+
 void UMyLearningAgentsEnv::ResetAgentEpisode_Implementation(
     const int32 AgentId
 )
@@ -104,7 +140,54 @@ void UMyLearningAgentsEnv::ResetAgentEpisode_Implementation(
     ACapStoneCharacter* ResetCharacter = Cast<ACapStoneCharacter>(ResetActor);
     if (ResetCharacter)
     {
+        // stage 가 바뀌면 이번 reset 부터 새 거리로 시작한다
+        if (Curriculum)
+        {
+            Curriculum->EndEpisode(ResetCharacter);
+        }
+
         ResetCharacter->RLResetCharacter();
+
+        // 같은 스텝의 observation 이 리셋된 상태를 보도록 스냅샷 갱신. 이 캐릭터와 되살아난 적을 보는 다른 agent 의 적 정보도 같이
+        if (AgentSnapshot)
+        {
+            AgentSnapshot->UpdateResetAgent(ResetCharacter);
+        }
     }
 }
 
+
+
+void UMyLearningAgentsEnv::ResetAgentEpisodes_Implementation(
+    const TArray<int32>& AgentIds
+)
+{
+    for (const int32 AgentId : AgentIds)
+    {
+        PendingResets.AddUnique(AgentId);
+    }
+
+    if (!bDeferResets)
+    {
+        FlushPendingResets();
+    }
+}
+
+int32 UMyLearningAgentsEnv::FlushPendingResets()
+{
+    if (PendingResets.Num() == 0)
+    {
+        return 0;
+    }
+
+    CAPSTONE_RL_SCOPE(ResetEpisodes);
+
+    const int32 ResetNum = PendingResets.Num();
+    for (const int32 AgentId : PendingResets)
+    {
+        ResetAgentEpisode_Implementation(AgentId);
+    }
+    PendingResets.Reset();
+
+    return ResetNum;
+}
@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "LearningAgentsTrainingEnvironment.h"
+#include "CapStoneAgentSnapshot.h"
+#include "CapStoneRewardEvaluator.h"
+#include "CapStoneCurriculum.h"
 #include "MyLearningAgentsEnv.generated.h"
 
 /**
@@ -19,6 +22,52 @@ public:
 
 	virtual void GatherAgentCompletion_Implementation(ELearningAgentsCompletion& OutCompletion, const int32 AgentId) override;
 
+	virtual void GatherAgentRewards_Implementation(TArray<float>& OutRewards, const TArray<int32>& AgentIds) override;
+
+	virtual void GatherAgentCompletions_Implementation(TArray<ELearningAgentsCompletion>& OutCompletions, const TArray<int32>& AgentIds) override;
+
 	virtual void ResetAgentEpisode_Implementation(const int32 AgentId) override;
 
+	/** 요청된 리셋을 모두 바로 처리한다. SetDeferResets(true) 이면 FlushPendingResets 까지 미룬다 */
+	virtual void ResetAgentEpisodes_Implementation(const TArray<int32>& AgentIds) override;
+
+	/** 미뤄 둔 리셋을 모두 처리하고 처리한 개수를 돌려준다 */
+	int32 FlushPendingResets();
+
+	int32 GetPendingResetNum() const { return PendingResets.Num(); }
+
+	void SetAgentSnapshot(FCapStoneAgentSnapshot* InAgentSnapshot) { AgentSnapshot = InAgentSnapshot; }
+
+	/** nullptr 이면 curriculum 없이 캐릭터의 고정 값으로 돈다 */
+	void SetCurriculum(FCapStoneCurriculum* InCurriculum) { Curriculum = InCurriculum; }
+
+	/**
+	 * true 이면 ResetAgentEpisodes 는 queue 에 넣기만 한다. Pipelined training 에서 쓴다.
+	 * ProcessExperience 가 TG_DuringPhysics 에서 리셋을 요청하므로 physics 가 끝난 뒤 FlushPendingResets 로 처리한다.
+	 */
+	void SetDeferResets(bool bInDeferResets) { bDeferResets = bInDeferResets; }
+
+	/** 마지막으로 모은 reward, completion 을 한 번만 돌려준다. Experience recorder 가 쓴다 */
+	bool ConsumeAgentOutcome(const int32 AgentId, float& OutReward, ELearningAgentsCompletion& OutCompletion);
+
+private:
+	FCapStoneAgentSnapshot* AgentSnapshot = nullptr;
+	FCapStoneCurriculum* Curriculum = nullptr;
+
+	/** Evaluates AgentIds unless the evaluator already holds results for the current snapshot version */
+	void EnsureEvaluated(const TArray<int32>& AgentIds);
+
+	FCapStoneRewardEvaluator RewardEvaluator;
+	// RewardEvaluator 가 계산한 스냅샷 버전. 스텝마다 reward, completion 어느 쪽이 먼저 불려도 한 번만 계산한다
+	uint32 EvaluatedVersion = 0;
+	bool bHasEvaluation = false;
+
+	TArray<int32> PendingResets;
+	bool bDeferResets = false;
+
+	// AgentId 로 index, 아직 소비되지 않은 reward, completion
+	TArray<float> LastRewards;
+	TArray<ELearningAgentsCompletion> LastCompletions;
+	TBitArray<> HasRewardOutcome;
+	TBitArray<> HasCompletionOutcome;
 };
@@ -6,80 +6,139 @@
 #include "LearningAgentsManagerListener.h"
 #include "LearningAgentsActions.h"
 #include "CapStoneCharacter.h"
+#include "CapStoneRLStats.h"
+#include "UObject/UnrealType.h"
+
+// Observation 구조는 FCapStoneAgentObservation 필드 순서를 그대로 따른다.
+// 이름은 observation struct 의 reflection 에서 한 번만 읽고 스텝마다 FName 을 만들거나 TMap 을 쓰지 않는다.
+// enum 순서가 필드 순서와 어긋나면 처음 읽을 때 check 에 걸린다.
+namespace CapStoneObservationSchema
+{
+    enum EAgentField { MyLocation, MyDirection, Enemy, ArmPoint, AgentFieldNum };
+    enum EEnemyField { EnemyLocation, EnemyDirection, EnemyFieldNum };
+    enum EArmPointField { RLocation, RRotation, LLocation, LRotation, ArmPointFieldNum };
+
+    static_assert(AgentFieldNum == FCapStoneAgentObservation::ObservedFieldNum, "EAgentField must list the observed fields");
+
+    /** The first FieldNum property names of Struct, in declaration order */
+    static TArray<FName> MakeFieldNames(const UScriptStruct* Struct, const int32 FieldNum)
+    {
+        TArray<FName> Names;
+        for (TFieldIterator<FProperty> It(Struct); It && Names.Num() < FieldNum; ++It)
+        {
+            Names.Add(It->GetFName());
+        }
+        check(Names.Num() == FieldNum);
+        return Names;
+    }
+
+    static const TArray<FName>& AgentNames()
+    {
+        static const TArray<FName> Names = []()
+        {
+            TArray<FName> Result = MakeFieldNames(FCapStoneAgentObservation::StaticStruct(), AgentFieldNum);
+            check(Result[MyLocation] == GET_MEMBER_NAME_CHECKED(FCapStoneAgentObservation, MyLocation));
+            check(Result[MyDirection] == GET_MEMBER_NAME_CHECKED(FCapStoneAgentObservation, MyDirection));
+            check(Result[Enemy] == GET_MEMBER_NAME_CHECKED(FCapStoneAgentObservation, Enemy));
+            check(Result[ArmPoint] == GET_MEMBER_NAME_CHECKED(FCapStoneAgentObservation, ArmPoint));
+            return Result;
+        }();
+        return Names;
+    }
+
+    static const TArray<FName>& EnemyNames()
+    {
+        static const TArray<FName> Names = []()
+        {
+            TArray<FName> Result = MakeFieldNames(FCapStoneEnemyObservation::StaticStruct(), EnemyFieldNum);
+            check(Result[EnemyLocation] == GET_MEMBER_NAME_CHECKED(FCapStoneEnemyObservation, Location));
+            check(Result[EnemyDirection] == GET_MEMBER_NAME_CHECKED(FCapStoneEnemyObservation, Direction));
+            return Result;
+        }();
+        return Names;
+    }
+
+    static const TArray<FName>& ArmPointNames()
+    {
+        static const TArray<FName> Names = []()
+        {
+            TArray<FName> Result = MakeFieldNames(FCapStoneArmPointObservation::StaticStruct(), ArmPointFieldNum);
+            check(Result[RLocation] == GET_MEMBER_NAME_CHECKED(FCapStoneArmPointObservation, RLocation));
+            check(Result[RRotation] == GET_MEMBER_NAME_CHECKED(FCapStoneArmPointObservation, RRotation));
+            check(Result[LLocation] == GET_MEMBER_NAME_CHECKED(FCapStoneArmPointObservation, LLocation));
+            check(Result[LRotation] == GET_MEMBER_NAME_CHECKED(FCapStoneArmPointObservation, LRotation));
+            return Result;
+        }();
+        return Names;
+    }
+}
 
 void UMyLearningAgentsInteractor::SpecifyAgentObservation_Implementation(
     FLearningAgentsObservationSchemaElement& OutObservationSchemaElement,
     ULearningAgentsObservationSchema* InObservationSchema
 )
 {
-    TMap<FName, FLearningAgentsObservationSchemaElement> Map;
-    TMap<FName, FLearningAgentsObservationSchemaElement> EnemyMap;
-    TMap<FName, FLearningAgentsObservationSchemaElement> ArmPointMap;
+    using namespace CapStoneObservationSchema;
 
-    // Specify Enemy Map
-    FLearningAgentsObservationSchemaElement EnemyLocation = 
+    TArray<FLearningAgentsObservationSchemaElement> Elements;
+    TArray<FLearningAgentsObservationSchemaElement> EnemyElements;
+    TArray<FLearningAgentsObservationSchemaElement> ArmPointElements;
+    Elements.SetNum(AgentFieldNum);
+    EnemyElements.SetNum(EnemyFieldNum);
+    ArmPointElements.SetNum(ArmPointFieldNum);
+
+    // Specify Enemy
+    EnemyElements[EnemyLocation] = 
     ULearningAgentsObservations::SpecifyLocationObservation(
-        InObservationSchema, 100.f);
-    
-    FLearningAgentsObservationSchemaElement EnemyDirection = 
+        InObservationSchema, LocationScale);
+    EnemyElements[EnemyDirection] = 
     ULearningAgentsObservations::SpecifyDirectionObservation(
         InObservationSchema);
-    
-    EnemyMap.Add(TEXT("Location"), EnemyLocation);
-    EnemyMap.Add(TEXT("Direction"), EnemyDirection);
-    
+
     FLearningAgentsObservationSchemaElement EnemyStruct = 
-    ULearningAgentsObservations::SpecifyStructObservation(
-        InObservationSchema, EnemyMap);
+    ULearningAgentsObservations::SpecifyStructObservationFromArrays(
+        InObservationSchema, EnemyNames(), EnemyElements);
 
-    FLearningAgentsObservationSchemaElement EnemyArray = 
+    Elements[Enemy] = 
     ULearningAgentsObservations::SpecifyArrayObservation(
         InObservationSchema, EnemyStruct, MaxEnemyArrayNum
     );
 
-    // Specify Arm Point Map
-    FLearningAgentsObservationSchemaElement RightLocation = 
+    // Specify Arm Point
+    ArmPointElements[RLocation] = 
     ULearningAgentsObservations::SpecifyLocationObservation(
-        InObservationSchema, 100.f);
-
-    FLearningAgentsObservationSchemaElement RightRotation = 
+        InObservationSchema, LocationScale);
+    ArmPointElements[RRotation] = 
     ULearningAgentsObservations::SpecifyRotationObservation(
         InObservationSchema);
-
-    FLearningAgentsObservationSchemaElement LeftLocation = 
+    ArmPointElements[LLocation] = 
     ULearningAgentsObservations::SpecifyLocationObservation(
-        InObservationSchema, 100.f);
-
-    FLearningAgentsObservationSchemaElement LeftRotation = 
+        InObservationSchema, LocationScale);
+    ArmPointElements[LRotation] = 
     ULearningAgentsObservations::SpecifyRotationObservation(
         InObservationSchema);
 
-    ArmPointMap.Add(TEXT("RLocation"), RightLocation);
-    ArmPointMap.Add(TEXT("RRotation"), RightRotation);
-    ArmPointMap.Add(TEXT("LLocation"), LeftLocation);
-    ArmPointMap.Add(TEXT("LRotation"), LeftRotation);
-
-    FLearningAgentsObservationSchemaElement ArmPointStruct = 
-    ULearningAgentsObservations::SpecifyStructObservation(
-        InObservationSchema, ArmPointMap);
+    Elements[ArmPoint] = 
+    ULearningAgentsObservations::SpecifyStructObservationFromArrays(
+        InObservationSchema, ArmPointNames(), ArmPointElements);
 
-    // Specify Map
-    FLearningAgentsObservationSchemaElement Location = 
+    // Specify Agent
+    Elements[MyLocation] = 
     ULearningAgentsObservations::SpecifyLocationObservation(
-        InObservationSchema, 100.f);
-
-    FLearningAgentsObservationSchemaElement Direction = 
+        InObservationSchema, LocationScale);
+    Elements[MyDirection] = 
     ULearningAgentsObservations::SpecifyDirectionObservation(
         InObservationSchema);
 
-    Map.Add(TEXT("MyLocation"), Location);
-    Map.Add(TEXT("MyDirection"), Direction);
-    Map.Add(TEXT("Enemy"), EnemyArray);
-    Map.Add(TEXT("ArmPoint"), ArmPointStruct);
-
     OutObservationSchemaElement = 
-    ULearningAgentsObservations::SpecifyStructObservation(
-        InObservationSchema, Map);
+    ULearningAgentsObservations::SpecifyStructObservationFromArrays(
+        InObservationSchema, AgentNames(), Elements);
+
+    // Gather 에서 재사용할 버퍼를 미리 잡아둔다
+    ObservationElements.SetNum(AgentFieldNum);
+    EnemyObservationElements.SetNum(EnemyFieldNum);
+    ArmPointObservationElements.SetNum(ArmPointFieldNum);
+    EnemyArrayElements.Reserve(MaxEnemyArrayNum);
 }
 
 void UMyLearningAgentsInteractor::GatherAgentObservation_Implementation(
@@ -88,107 +147,106 @@ void UMyLearningAgentsInteractor::GatherAgentObservation_Implementation(
     const int32 AgentId
 )
 {
-    TMap<FName, FLearningAgentsObservationObjectElement> Map;
-    TMap<FName, FLearningAgentsObservationObjectElement> EnemyMap;
-    TMap<FName, FLearningAgentsObservationObjectElement> ArmPointMap;
-
-    UObject* ObsActor = ULearningAgentsManagerListener::GetAgent(AgentId);
-    ACapStoneCharacter* ObsCharacter = Cast<ACapStoneCharacter>(ObsActor);
-    if (ObsCharacter)
+    if (AgentSnapshot && AgentSnapshot->IsValid(AgentId))
     {
-        // Gather Enemy Map
-        FTransform Transform = ObsCharacter->GetActorTransform();
-
-        TArray<FLearningAgentsObservationObjectElement> EnemyElement;
-        EnemyElement.Empty();
+        Observation.Fill(*AgentSnapshot, AgentId);
+        LocalObservation.Encode(Observation);
+        OutObservationObjectElement = EncodeObservation(InObservationObject, LocalObservation);
+    }
+    else
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Agent %d is missing from the agent snapshot!"), AgentId);
+    }
+}
 
-        const TArray<FVector>& Locations = ObsCharacter->GetEnemyLocation();
-        const TArray<FVector>& Directions = ObsCharacter->GetEnemyDirection();
-        int32 Count = FMath::Min(Locations.Num(), Directions.Num());
+void UMyLearningAgentsInteractor::GatherAgentObservations_Implementation(
+    TArray<FLearningAgentsObservationObjectElement>& OutObservationObjectElements,
+    ULearningAgentsObservationObject* InObservationObject,
+    const TArray<int32>& AgentIds
+)
+{
+    CAPSTONE_RL_SCOPE(GatherObservations);
 
-        for (int32 i = 0; i < Count; ++i)
+    // Make*Observation 은 observation object 의 공용 버퍼에 element 를 덧붙이므로 agent 마다 차례로 한다
+    OutObservationObjectElements.SetNum(AgentIds.Num());
+    for (int32 Index = 0; Index < AgentIds.Num(); ++Index)
+    {
+        const int32 AgentId = AgentIds[Index];
+        if (AgentSnapshot && AgentSnapshot->IsValid(AgentId))
         {
-            const FVector& Location = Locations[i];
-            const FVector& Direction = Directions[i];
-
-            FLearningAgentsObservationObjectElement EnemyLocation = 
-                ULearningAgentsObservations::MakeLocationObservation(
-                    InObservationObject, Location, Transform);
-
-            FLearningAgentsObservationObjectElement EnemyDirection = 
-                ULearningAgentsObservations::MakeDirectionObservation(
-                    InObservationObject, Direction, Transform);
-
-            EnemyMap.Add(TEXT("Location"), EnemyLocation);
-            EnemyMap.Add(TEXT("Direction"), EnemyDirection);
-
-            FLearningAgentsObservationObjectElement EnemyStruct = 
-            ULearningAgentsObservations::MakeStructObservation(
-                InObservationObject, EnemyMap);
-            
-            EnemyElement.Add(EnemyStruct);
+            Observation.Fill(*AgentSnapshot, AgentId);
+            LocalObservation.Encode(Observation);
+            OutObservationObjectElements[Index] = EncodeObservation(InObservationObject, LocalObservation);
         }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Agent %d is missing from the agent snapshot!"), AgentId);
+        }
+    }
+}
 
-        FLearningAgentsObservationObjectElement EnemyArray =
-        ULearningAgentsObservations::MakeArrayObservation(
-            InObservationObject, EnemyElement, MaxEnemyArrayNum
-        );
+FLearningAgentsObservationObjectElement UMyLearningAgentsInteractor::EncodeObservation(
+    ULearningAgentsObservationObject* InObservationObject,
+    const FCapStoneLocalObservation& InObservation
+)
+{
+    using namespace CapStoneObservationSchema;
 
-        // Gather Arm Point Map
-        FRotator Rotation = ObsCharacter->GetActorRotation();
+    check(ObservationElements.Num() == AgentFieldNum);
 
-        FVector RLocation = ObsCharacter->GetRightPoint()->GetComponentLocation();
-        FRotator RRotation = ObsCharacter->GetRightPoint()->GetComponentRotation();
-        FVector LLocation = ObsCharacter->GetLeftPoint()->GetComponentLocation();
-        FRotator LRotation = ObsCharacter->GetLeftPoint()->GetComponentRotation();
+    // 값은 이미 agent 기준이므로 identity 기준으로 넣는다
+    const FTransform& Transform = FTransform::Identity;
+    const FRotator& Rotation = FRotator::ZeroRotator;
 
-        FLearningAgentsObservationObjectElement RightLocation =
-        ULearningAgentsObservations::MakeLocationObservation(
-            InObservationObject, RLocation, Transform
-        );
-        FLearningAgentsObservationObjectElement RightRotation =
-        ULearningAgentsObservations::MakeRotationObservation(
-           InObservationObject, RRotation, Rotation
-        );
-        FLearningAgentsObservationObjectElement LeftLocation =
-        ULearningAgentsObservations::MakeLocationObservation(
-            InObservationObject, LLocation, Transform
-        );
-        FLearningAgentsObservationObjectElement LeftRotation =
-        ULearningAgentsObservations::MakeRotationObservation(
-           InObservationObject, LRotation, Rotation
-        );
-
-        ArmPointMap.Add(TEXT("RLocation"), RightLocation);
-        ArmPointMap.Add(TEXT("RRotation"), RightRotation);
-        ArmPointMap.Add(TEXT("LLocation"), LeftLocation);
-        ArmPointMap.Add(TEXT("LRotation"), LeftRotation);
-
-        FLearningAgentsObservationObjectElement ArmPointStruct = 
-        ULearningAgentsObservations::MakeStructObservation(
-        InObservationObject, ArmPointMap);
-
-        // Gather Map
-        FLearningAgentsObservationObjectElement Location = 
+    // Encode Enemy
+    EnemyArrayElements.Reset();
+    for (int32 i = 0; i < InObservation.EnemyNum; ++i)
+    {
+        EnemyObservationElements[EnemyLocation] = 
         ULearningAgentsObservations::MakeLocationObservation(
-            InObservationObject, ObsCharacter->GetActorLocation(), Transform);
-        FLearningAgentsObservationObjectElement Direction = 
+            InObservationObject, InObservation.EnemyLocation[i], Transform);
+        EnemyObservationElements[EnemyDirection] = 
         ULearningAgentsObservations::MakeDirectionObservation(
-            InObservationObject, ObsCharacter->GetActorForwardVector(), Transform);
-
-        Map.Add(TEXT("MyLocation"), Location);
-        Map.Add(TEXT("MyDirection"), Direction);
-        Map.Add(TEXT("Enemy"), EnemyArray);
-        Map.Add(TEXT("ArmPoint"), ArmPointStruct);
+            InObservationObject, InObservation.EnemyDirection[i], Transform);
 
-        OutObservationObjectElement = 
-        ULearningAgentsObservations::MakeStructObservation(
-        InObservationObject, Map);
-    }
-    else
-    {
-        UE_LOG(LogTemp, Warning, TEXT("Cast to ACapStoneCharacter failed!"));
+        EnemyArrayElements.Add(
+            ULearningAgentsObservations::MakeStructObservationFromArrays(
+                InObservationObject, EnemyNames(), EnemyObservationElements));
     }
+
+    ObservationElements[Enemy] =
+    ULearningAgentsObservations::MakeArrayObservation(
+        InObservationObject, EnemyArrayElements, MaxEnemyArrayNum
+    );
+
+    // Encode Arm Point
+    ArmPointObservationElements[RLocation] =
+    ULearningAgentsObservations::MakeLocationObservation(
+        InObservationObject, InObservation.RLocation, Transform);
+    ArmPointObservationElements[RRotation] =
+    ULearningAgentsObservations::MakeRotationObservation(
+        InObservationObject, InObservation.RRotation, Rotation);
+    ArmPointObservationElements[LLocation] =
+    ULearningAgentsObservations::MakeLocationObservation(
+        InObservationObject, InObservation.LLocation, Transform);
+    ArmPointObservationElements[LRotation] =
+    ULearningAgentsObservations::MakeRotationObservation(
+        InObservationObject, InObservation.LRotation, Rotation);
+
+    ObservationElements[ArmPoint] = 
+    ULearningAgentsObservations::MakeStructObservationFromArrays(
+        InObservationObject, ArmPointNames(), ArmPointObservationElements);
+
+    // Encode Agent
+    ObservationElements[MyLocation] = 
+    ULearningAgentsObservations::MakeLocationObservation(
+        InObservationObject, InObservation.MyLocation, Transform);
+    ObservationElements[MyDirection] = 
+    ULearningAgentsObservations::MakeDirectionObservation(
+        InObservationObject, InObservation.MyDirection, Transform);
+
+    return ULearningAgentsObservations::MakeStructObservationFromArrays(
+        InObservationObject, AgentNames(), ObservationElements);
 }
 
 FLearningAgentsActionSchemaElement UMyLearningAgentsInteractor::MakeStructAction3Location3Rotation(
@@ -277,136 +335,232 @@ void UMyLearningAgentsInteractor::PerformAgentAction_Implementation(
     const int32 AgentId
 )
 {
-    UObject* ActActor = ULearningAgentsManagerListener::GetAgent(AgentId);
-    ACapStoneCharacter* ActCharacter = Cast<ACapStoneCharacter>(ActActor);
-    if (ActCharacter)
+    // 한 agent 만 들어오는 경우도 같은 decode / apply 경로를 쓴다
+    if (DecodeAgentAction(InActionObject, InActionObjectElement, AgentId))
     {
-        TMap<FName, FLearningAgentsActionObjectElement> OutActions;
-
-        ULearningAgentsActions::GetStructAction(OutActions, InActionObject, InActionObjectElement);
-        
-        // Perform Movement
-        TMap<FName, FLearningAgentsActionObjectElement> MovementActions;
-        ULearningAgentsActions::GetStructAction(
-            MovementActions, InActionObject, *OutActions.Find(TEXT("Movement")));
-        
-        float XMovement;
-        ULearningAgentsActions::GetFloatAction(
-            XMovement, InActionObject, *MovementActions.Find(TEXT("X"))
-        );
-        ActCharacter->RLMove(FVector2D(XMovement, 0.0f));
-
-        float YMovement;
-        ULearningAgentsActions::GetFloatAction(
-            YMovement, InActionObject, *MovementActions.Find(TEXT("Y"))
-        );
-        ActCharacter->RLMove(FVector2D(0.0f, YMovement));
-
-        // Perform Rotation
-        float Rotation;
-        ULearningAgentsActions::GetFloatAction(
-            Rotation, InActionObject, *OutActions.Find(TEXT("Rotation"))
-        );
-        ActCharacter->RLLook(FVector2D(Rotation, 0.0f));
-
-        // Perform Right
-        TMap<FName, FLearningAgentsActionObjectElement> Right;
-        ULearningAgentsActions::GetStructAction(
-            Right, InActionObject, *OutActions.Find(TEXT("Right")));
-    
-        ApplyDiscreteActionMove(InActionObject, Right, TEXT("LocationX"), 
-        ActCharacter, FVector(1, 0, 0), &ACapStoneCharacter::RLRightPointMove);
-        ApplyDiscreteActionMove(InActionObject, Right, TEXT("LocationY"), 
-        ActCharacter, FVector(0, 1, 0), &ACapStoneCharacter::RLRightPointMove);
-        ApplyDiscreteActionMove(InActionObject, Right, TEXT("LocationZ"), 
-        ActCharacter, FVector(0, 0, 1), &ACapStoneCharacter::RLRightPointMove);
-
-        ApplyDiscreteActionRotate(InActionObject, Right, TEXT("RotationX"),
-        ActCharacter, FRotator(1, 0, 0), &ACapStoneCharacter::GetRightPoint);
-        ApplyDiscreteActionRotate(InActionObject, Right, TEXT("RotationY"),
-        ActCharacter, FRotator(0, 1, 0), &ACapStoneCharacter::GetRightPoint);
-        ApplyDiscreteActionRotate(InActionObject, Right, TEXT("RotationZ"),
-        ActCharacter, FRotator(0, 0, 1), &ACapStoneCharacter::GetRightPoint);
-    
-        // Perform Left
-        TMap<FName, FLearningAgentsActionObjectElement> Left;
-        ULearningAgentsActions::GetStructAction(
-            Left, InActionObject, *OutActions.Find(TEXT("Left")));
-    
-        ApplyDiscreteActionMove(InActionObject, Left, TEXT("LocationX"), 
-        ActCharacter, FVector(1, 0, 0), &ACapStoneCharacter::RLLeftPointMove);
-        ApplyDiscreteActionMove(InActionObject, Left, TEXT("LocationY"), 
-        ActCharacter, FVector(0, 1, 0), &ACapStoneCharacter::RLLeftPointMove);
-        ApplyDiscreteActionMove(InActionObject, Left, TEXT("LocationZ"), 
-        ActCharacter, FVector(0, 0, 1), &ACapStoneCharacter::RLLeftPointMove);
-
-        ApplyDiscreteActionRotate(InActionObject, Left, TEXT("RotationX"),
-        ActCharacter, FRotator(1, 0, 0), &ACapStoneCharacter::GetLeftPoint);
-        ApplyDiscreteActionRotate(InActionObject, Left, TEXT("RotationY"),
-        ActCharacter, FRotator(0, 1, 0), &ACapStoneCharacter::GetLeftPoint);
-        ApplyDiscreteActionRotate(InActionObject, Left, TEXT("RotationZ"),
-        ActCharacter, FRotator(0, 0, 1), &ACapStoneCharacter::GetLeftPoint);
+        if (!HasCommand.IsValidIndex(AgentId))
+        {
+            HasCommand.SetNum(AgentId + 1, false);
+        }
+        HasCommand[AgentId] = true;
+
+        ApplyAgentCommand(AgentId);
     }
-    else
+}
+
+void UMyLearningAgentsInteractor::PerformAgentActions_Implementation(
+    const ULearningAgentsActionObject* InActionObject, 
+    const TArray<FLearningAgentsActionObjectElement>& InActionObjectElements, 
+    const TArray<int32>& AgentIds
+)
+{
+    CAPSTONE_RL_SCOPE(PerformActions);
+
+    if (AgentSnapshot && HasCommand.Num() < AgentSnapshot->GetMaxAgentNum())
     {
-        UE_LOG(LogTemp, Warning, TEXT("Cast to ACapStoneCharacter failed!"));
+        HasCommand.SetNum(AgentSnapshot->GetMaxAgentNum(), false);
+    }
+
+    // 들어온 agent 는 새 command 를 decode 해서 전부 적용한다. decode 에 실패하면 이전 이동, 회전만 유지
+    for (int32 Index = 0; Index < AgentIds.Num(); ++Index)
+    {
+        const int32 AgentId = AgentIds[Index];
+        if (!HasCommand.IsValidIndex(AgentId) || !AgentSnapshot->IsValid(AgentId))
+        {
+            continue;
+        }
+
+        if (DecodeAgentAction(InActionObject, InActionObjectElements[Index], AgentId))
+        {
+            HasCommand[AgentId] = true;
+            CapStoneRLTrace::AgentDecision(AgentId);
+            ApplyAgentCommand(AgentId);
+        }
+        else if (HasCommand[AgentId])
+        {
+            HoldAgentCommand(AgentId);
+        }
     }
 }
 
-// 원본 코드
-// int32 LocationX;
-// ULearningAgentsActions::GetExclusiveDiscreteAction(
-//     LocationX, InActionObject, *Right.Find(TEXT("LocationX")));
-// LocationX = (LocationX - 1) * LocationAmount;
-// ActCharacter->RLRightPointMove(FVector((float)LocationX, 0.0f, 0.0f));
+void UMyLearningAgentsInteractor::HoldLastCommands(const TBitArray<>* DecidedMask)
+{
+    if (!AgentSnapshot)
+    {
+        return;
+    }
+
+    CAPSTONE_RL_SCOPE(PerformActions);
 
-void UMyLearningAgentsInteractor::ApplyDiscreteActionMove(
+    for (TConstSetBitIterator<> It(HasCommand); It; ++It)
+    {
+        const int32 AgentId = It.GetIndex();
+        const bool bDecided = DecidedMask && DecidedMask->IsValidIndex(AgentId) && (*DecidedMask)[AgentId];
+        if (!bDecided && AgentSnapshot->IsValid(AgentId))
+        {
+            HoldAgentCommand(AgentId);
+        }
+    }
+}
+
+bool UMyLearningAgentsInteractor::ResolveActionTable(
     const ULearningAgentsActionObject* InActionObject,
-    const TMap<FName, FLearningAgentsActionObjectElement>& ActionMap,
-    const FName& KeyName,
-    ACapStoneCharacter* ActCharacter,
-    const FVector& MoveAxis,
-    void (ACapStoneCharacter::*MoveFunc)(FVector)
+    const FLearningAgentsActionObjectElement& InActionObjectElement
 )
 {
-    int32 LocationIndex;
-    if (ULearningAgentsActions::GetExclusiveDiscreteAction(LocationIndex, InActionObject, *ActionMap.Find(KeyName)))
+    static const FName HandFieldNames[FCapStoneActionTable::HandFieldNum] = {
+        TEXT("LocationX"), TEXT("LocationY"), TEXT("LocationZ"),
+        TEXT("RotationX"), TEXT("RotationY"), TEXT("RotationZ") };
+
+    ActionTable.bResolved = true;
+    ActionTable.bValid = false;
+
+    ULearningAgentsActions::GetStructActionToArrays(
+        ActionNames, ActionElements, InActionObject, InActionObjectElement);
+
+    ActionTable.Movement = ActionNames.IndexOfByKey(FName(TEXT("Movement")));
+    ActionTable.Rotation = ActionNames.IndexOfByKey(FName(TEXT("Rotation")));
+    ActionTable.Right = ActionNames.IndexOfByKey(FName(TEXT("Right")));
+    ActionTable.Left = ActionNames.IndexOfByKey(FName(TEXT("Left")));
+
+    if (ActionTable.Movement == INDEX_NONE || ActionTable.Rotation == INDEX_NONE ||
+        ActionTable.Right == INDEX_NONE || ActionTable.Left == INDEX_NONE)
     {
-        int32 AdjustedLocation = (LocationIndex - 1) * LocationAmount;
-        FVector MoveVector = MoveAxis * (float)AdjustedLocation;
-        (ActCharacter->*MoveFunc)(MoveVector);
+        UE_LOG(LogTemp, Error, TEXT("Action schema does not match the action decoding table!"));
+        return false;
+    }
 
-        if(AdjustedLocation != 0)
-        {
-            ActCharacter->SetStamina(ActCharacter->GetStamina() + 1);
-        }
+    ULearningAgentsActions::GetStructActionToArrays(
+        MovementNames, MovementElements, InActionObject, ActionElements[ActionTable.Movement]);
+    ULearningAgentsActions::GetStructActionToArrays(
+        RightNames, RightElements, InActionObject, ActionElements[ActionTable.Right]);
+    ULearningAgentsActions::GetStructActionToArrays(
+        LeftNames, LeftElements, InActionObject, ActionElements[ActionTable.Left]);
+
+    ActionTable.MovementX = MovementNames.IndexOfByKey(FName(TEXT("X")));
+    ActionTable.MovementY = MovementNames.IndexOfByKey(FName(TEXT("Y")));
+
+    bool bValid = 
+        ActionTable.MovementX != INDEX_NONE && ActionTable.MovementY != INDEX_NONE &&
+        RightNames == LeftNames;
+
+    for (int32 Field = 0; Field < FCapStoneActionTable::HandFieldNum; ++Field)
+    {
+        ActionTable.Hand[Field] = RightNames.IndexOfByKey(HandFieldNames[Field]);
+        bValid &= ActionTable.Hand[Field] != INDEX_NONE;
+    }
+
+    ActionTable.bValid = bValid;
+    if (!bValid)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Action schema does not match the action decoding table!"));
     }
+    return bValid;
 }
 
-void UMyLearningAgentsInteractor::ApplyDiscreteActionRotate(
+bool UMyLearningAgentsInteractor::DecodeAgentAction(
     const ULearningAgentsActionObject* InActionObject,
-    const TMap<FName, FLearningAgentsActionObjectElement>& ActionMap,
-    const FName& KeyName,
-    ACapStoneCharacter* ActCharacter,
-    const FRotator& RotateAxis,
-    USceneComponent* (ACapStoneCharacter::*GetPointFunc)() const
+    const FLearningAgentsActionObjectElement& InActionObjectElement,
+    const int32 AgentId
 )
 {
-    int32 RotationIndex;
-    if (ULearningAgentsActions::GetExclusiveDiscreteAction(RotationIndex, InActionObject, *ActionMap.Find(KeyName)))
+    if (!AgentSnapshot || !AgentSnapshot->IsValid(AgentId))
     {
-        int32 AdjustedRotation = (RotationIndex - 1) * RotationAmount;
-        FRotator RotateVector = RotateAxis * (float)AdjustedRotation;
+        UE_LOG(LogTemp, Warning, TEXT("Agent %d is missing from the agent snapshot!"), AgentId);
+        return false;
+    }
 
-        USceneComponent* TargetComponent = (ActCharacter->*GetPointFunc)();
-        if (TargetComponent)
-        {
-            TargetComponent->AddLocalRotation(RotateVector);
+    // 첫 decode 때 한 번만 이름 -> index 테이블을 만든다
+    if (!ActionTable.bResolved)
+    {
+        ResolveActionTable(InActionObject, InActionObjectElement);
+    }
+    if (!ActionTable.bValid)
+    {
+        return false;
+    }
 
-            if (AdjustedRotation != 0)
-            {
-                ActCharacter->SetStamina(ActCharacter->GetStamina() + 1);
-            }
-        }
+    // element handle 은 agent 마다 새로 만들어지므로 struct 4개는 매번 펼친다. index 는 ActionTable 로 바로 찾는다
+    ULearningAgentsActions::GetStructActionToArrays(
+        ActionNames, ActionElements, InActionObject, InActionObjectElement);
+    ULearningAgentsActions::GetStructActionToArrays(
+        MovementNames, MovementElements, InActionObject, ActionElements[ActionTable.Movement]);
+    ULearningAgentsActions::GetStructActionToArrays(
+        RightNames, RightElements, InActionObject, ActionElements[ActionTable.Right]);
+    ULearningAgentsActions::GetStructActionToArrays(
+        LeftNames, LeftElements, InActionObject, ActionElements[ActionTable.Left]);
+
+    if (Commands.Num() < AgentSnapshot->GetMaxAgentNum())
+    {
+        Commands.SetNum(AgentSnapshot->GetMaxAgentNum());
+    }
+    FCapStoneAgentCommand& Command = Commands[AgentId];
+
+    // Movement, Rotation
+    ULearningAgentsActions::GetFloatAction(
+        Command.Move.X, InActionObject, MovementElements[ActionTable.MovementX]);
+    ULearningAgentsActions::GetFloatAction(
+        Command.Move.Y, InActionObject, MovementElements[ActionTable.MovementY]);
+    ULearningAgentsActions::GetFloatAction(
+        Command.Look, InActionObject, ActionElements[ActionTable.Rotation]);
+
+    // Right, Left : discrete index 0, 1, 2 -> -1, 0, 1
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        Command.RightMove[Axis] = DecodeDiscreteStep(InActionObject, RightElements[ActionTable.Hand[Axis]]);
+        Command.RightRotate[Axis] = DecodeDiscreteStep(InActionObject, RightElements[ActionTable.Hand[Axis + 3]]);
+        Command.LeftMove[Axis] = DecodeDiscreteStep(InActionObject, LeftElements[ActionTable.Hand[Axis]]);
+        Command.LeftRotate[Axis] = DecodeDiscreteStep(InActionObject, LeftElements[ActionTable.Hand[Axis + 3]]);
+    }
+
+    return true;
+}
+
+int32 UMyLearningAgentsInteractor::DecodeDiscreteStep(
+    const ULearningAgentsActionObject* InActionObject,
+    const FLearningAgentsActionObjectElement& InElement
+) const
+{
+    int32 Index;
+    if (ULearningAgentsActions::GetExclusiveDiscreteAction(Index, InActionObject, InElement))
+    {
+        return Index - 1;
+    }
+    return 0;
+}
+
+void UMyLearningAgentsInteractor::ApplyAgentCommand(const int32 AgentId)
+{
+    ACapStoneCharacter* ActCharacter = AgentSnapshot->Characters[AgentId];
+    const FCapStoneAgentCommand& Command = Commands[AgentId];
+
+    // Perform Movement, Rotation
+    HoldAgentCommand(AgentId);
+
+    // Perform Right, Left : 이동 후 회전, point 마다 transform 갱신 한 번
+    ActCharacter->RLApplyHandSteps(
+        Command.RightMove, Command.RightRotate, Command.LeftMove, Command.LeftRotate,
+        LocationAmount, RotationAmount);
+
+    int32 StaminaCost = 0;
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        StaminaCost += (Command.RightMove[Axis] != 0) + (Command.LeftMove[Axis] != 0)
+            + (Command.RightRotate[Axis] != 0) + (Command.LeftRotate[Axis] != 0);
     }
-}
\ No newline at end of file
+
+    if (StaminaCost != 0)
+    {
+        ActCharacter->SetStamina(ActCharacter->GetStamina() + StaminaCost);
+    }
+}
+
+void UMyLearningAgentsInteractor::HoldAgentCommand(const int32 AgentId)
+{
+    ACapStoneCharacter* ActCharacter = AgentSnapshot->Characters[AgentId];
+    const FCapStoneAgentCommand& Command = Commands[AgentId];
+
+    // 이동, 회전 입력은 매 tick 소비되므로 결정 사이에도 다시 넣는다. 손 이동과 stamina 는 결정마다 한 번
+    ActCharacter->RLMove(Command.Move);
+    ActCharacter->RLLook(FVector2D(Command.Look, 0.0f));
+}
@@ -3,11 +3,48 @@
 #pragma once
 
 #include "CapStoneCharacter.h"
+#include "CapStoneAgentSnapshot.h"
+#include "CapStoneObservation.h"
 
 #include "CoreMinimal.h"
 #include "LearningAgentsInteractor.h"
 #include "MyLearningAgentsInteractor.generated.h"
 
+/** Per-agent action decoded once per step and applied in a tight loop */
+struct FCapStoneAgentCommand
+{
+	FVector2D Move = FVector2D::ZeroVector;
+	float Look = 0.0f;
+
+	// 축마다 -1, 0, 1
+	FIntVector RightMove = FIntVector::ZeroValue;
+	FIntVector RightRotate = FIntVector::ZeroValue;
+	FIntVector LeftMove = FIntVector::ZeroValue;
+	FIntVector LeftRotate = FIntVector::ZeroValue;
+};
+
+/**
+ * Positions of the action struct elements, resolved from the action schema on the first decode.
+ * Only positions inside GetStructActionToArrays' output can be cached: the element handles themselves are not stable.
+ */
+struct FCapStoneActionTable
+{
+	static constexpr int32 HandFieldNum = 6;
+
+	bool bResolved = false;
+	bool bValid = false;
+
+	int32 Movement = INDEX_NONE;
+	int32 Rotation = INDEX_NONE;
+	int32 Right = INDEX_NONE;
+	int32 Left = INDEX_NONE;
+	int32 MovementX = INDEX_NONE;
+	int32 MovementY = INDEX_NONE;
+
+	// LocationX, Y, Z, RotationX, Y, Z
+	int32 Hand[HandFieldNum] = { INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE };
+};
+
 /**
  * 
  */
@@ -20,36 +57,95 @@ public:
     virtual void SpecifyAgentObservation_Implementation(FLearningAgentsObservationSchemaElement& OutObservationSchemaElement, ULearningAgentsObservationSchema* InObservationSchema) override;
 	
 	virtual void GatherAgentObservation_Implementation(FLearningAgentsObservationObjectElement& OutObservationObjectElement, ULearningAgentsObservationObject* InObservationObject, const int32 AgentId) override;
+
+	virtual void GatherAgentObservations_Implementation(TArray<FLearningAgentsObservationObjectElement>& OutObservationObjectElements, ULearningAgentsObservationObject* InObservationObject, const TArray<int32>& AgentIds) override;
 	
 	virtual void SpecifyAgentAction_Implementation(FLearningAgentsActionSchemaElement& OutActionSchemaElement, ULearningAgentsActionSchema* InActionSchema) override;
 	
 	virtual void PerformAgentAction_Implementation(const ULearningAgentsActionObject* InActionObject, const FLearningAgentsActionObjectElement& InActionObjectElement, const int32 AgentId) override;
+
+	virtual void PerformAgentActions_Implementation(const ULearningAgentsActionObject* InActionObject, const TArray<FLearningAgentsActionObjectElement>& InActionObjectElements, const TArray<int32>& AgentIds) override;
+
+	void SetAgentSnapshot(const FCapStoneAgentSnapshot* InAgentSnapshot) { AgentSnapshot = InAgentSnapshot; }
+
+	/**
+	 * Holds the last movement and look input of every agent with a command, except those set in DecidedMask.
+	 * Hand steps and stamina are only applied on decisions. Pass the set that just went through PerformActions as DecidedMask.
+	 */
+	void HoldLastCommands(const TBitArray<>* DecidedMask = nullptr);
+
 private:
+	const FCapStoneAgentSnapshot* AgentSnapshot = nullptr;
+
+	FLearningAgentsObservationObjectElement EncodeObservation(
+		ULearningAgentsObservationObject* InObservationObject,
+		const FCapStoneLocalObservation& InObservation
+	);
+
+	// Gather 중에 재사용하는 버퍼, 스텝마다 할당하지 않는다.
+	// Interactor 하나가 한 번에 한 gather 만 한다고 가정하므로 thread safe 하지 않다. game thread 에서만 gather 한다
+	FCapStoneAgentObservation Observation;
+	FCapStoneLocalObservation LocalObservation;
+	TArray<FLearningAgentsObservationObjectElement> ObservationElements;
+	TArray<FLearningAgentsObservationObjectElement> EnemyObservationElements;
+	TArray<FLearningAgentsObservationObjectElement> EnemyArrayElements;
+	TArray<FLearningAgentsObservationObjectElement> ArmPointObservationElements;
+
 	FLearningAgentsActionSchemaElement MakeStructAction3Location3Rotation(
 		ULearningAgentsActionSchema* InActionSchema
 	);
 
-	void ApplyDiscreteActionMove(
+	bool ResolveActionTable(
 		const ULearningAgentsActionObject* InActionObject,
-		const TMap<FName, FLearningAgentsActionObjectElement>& ActionMap,
-		const FName& KeyName,
-		ACapStoneCharacter* ActCharacter,
-		const FVector& MoveAxis,
-		void (ACapStoneCharacter::*MoveFunc)(FVector)
+		const FLearningAgentsActionObjectElement& InActionObjectElement
 	);
 
-	void ApplyDiscreteActionRotate(
+	/**
+	 * Reads one agent's action into Commands[AgentId].
+	 * Learning Agents builds a new action object element tree for every agent on every decode and only exposes it through
+	 * FLearningAgentsActionObjectElement handles, so the four struct elements (root, Movement, Right, Left) are re-read with
+	 * GetStructActionToArrays per agent. ActionTable removes the name lookups; the handles cannot be resolved once and reused.
+	 */
+	bool DecodeAgentAction(
 		const ULearningAgentsActionObject* InActionObject,
-		const TMap<FName, FLearningAgentsActionObjectElement>& ActionMap,
-		const FName& KeyName,
-		ACapStoneCharacter* ActCharacter,
-		const FRotator& RotateAxis,
-		USceneComponent* (ACapStoneCharacter::*GetPointFunc)() const
+		const FLearningAgentsActionObjectElement& InActionObjectElement,
+		const int32 AgentId
 	);
 
+	int32 DecodeDiscreteStep(
+		const ULearningAgentsActionObject* InActionObject,
+		const FLearningAgentsActionObjectElement& InElement
+	) const;
+
+	/** Once per decision: movement, look, hand steps and their stamina cost */
+	void ApplyAgentCommand(const int32 AgentId);
+
+	/** Every tick without a decision: movement and look input only */
+	void HoldAgentCommand(const int32 AgentId);
+
+	FCapStoneActionTable ActionTable;
+
+	// AgentId 로 index
+	TArray<FCapStoneAgentCommand> Commands;
+
+	// 한 번이라도 command 가 decode 된 agent, AgentId 로 index. 결정 사이에는 이 agent 들의 이동, 회전을 유지한다
+	TBitArray<> HasCommand;
+
+	// Decode 중에 재사용하는 버퍼, gather 버퍼와 마찬가지로 game thread 전용
+	TArray<FName> ActionNames;
+	TArray<FLearningAgentsActionObjectElement> ActionElements;
+	TArray<FName> MovementNames;
+	TArray<FLearningAgentsActionObjectElement> MovementElements;
+	TArray<FName> RightNames;
+	TArray<FLearningAgentsActionObjectElement> RightElements;
+	TArray<FName> LeftNames;
+	TArray<FLearningAgentsActionObjectElement> LeftElements;
+
+	float LocationScale = 100.f;
+
 	int LocationAmount = 5;
 	int RotationAmount = 5;
 
-	int MaxEnemyArrayNum = 4;
+	int MaxEnemyArrayNum = FCapStoneAgentObservation::MaxEnemyNum;
 	int DiscreteActionSize = 3;
 };
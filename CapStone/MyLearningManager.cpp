@@ -3,18 +3,31 @@
 #include "MyLearningManager.h"
 
 #include "Kismet/GameplayStatics.h"
+#include "Engine/Engine.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformProcess.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "GameFramework/WorldSettings.h"
 
 #include "LearningAgentsInteractor.h"
 #include "LearningAgentsPolicy.h"
 #include "LearningAgentsNeuralNetwork.h"
 #include "LearningNeuralNetwork.h"
+#include "LearningArray.h"
 #include "LearningAgentsCritic.h"
 #include "LearningAgentsTrainingEnvironment.h"
 #include "LearningAgentsCommunicator.h"
 #include "LearningAgentsTrainer.h"
 #include "LearningAgentsPPOTrainer.h"
+#include "LearningSharedMemoryTrainer.h"
 
 #include "CapStoneCharacter.h"
+#include "CapStoneEnemySubsystem.h"
+#include "CapStoneCombatSubsystem.h"
+#include "CapStoneNetworkRegistry.h"
+#include "CapStoneRLStats.h"
 #include "MyLearningAgentsInteractor.h"
 #include "MyLearningAgentsEnv.h"
 
@@ -64,6 +77,62 @@ void AMyLearningManager::BeginPlay()
         }
     }
 
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneArenaNum="), ArenaNum);
+	if (FParse::Param(FCommandLine::Get(), TEXT("CapStoneKinematicHands")))
+	{
+		bKinematicHands = true;
+	}
+	if (Benchmark.ParseCommandLine())
+	{
+		// inference 는 학습 process 없이 초기화된 (random) policy 로만 돌리고, training 은 설정된 trainer 와 RunTraining 을 돈다
+		RunInference = !Benchmark.IsTraining();
+		Benchmark.Begin();
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneSeed="), RunSeed);
+	if (RunSeed == 0)
+	{
+		RunSeed = FMath::Max(1, (int32)(FDateTime::Now().GetTicks() & MAX_int32));
+	}
+	Benchmark.RunSeed = RunSeed;
+	UE_LOG(LogTemp, Log, TEXT("Run seed %d. Pass -CapStoneSeed=%d to replay the same resets."), RunSeed, RunSeed);
+
+	// 레벨에 배치된 캐릭터는 생성될 arena 뒤의 번호를 arena index 대신 쓴다
+	for (int32 Index = 0; Index < ActorCharacters.Num(); ++Index)
+	{
+		ActorCharacters[Index]->SetRandomSeed(MakeCharacterSeed(ArenaNum + Index, ActorCharacters[Index]->GetTeamID()));
+	}
+
+	SpawnArenas();
+
+	// 레벨에 배치된 캐릭터는 이미 BeginPlay 를 지났을 수 있다. SetHandControl 이 다시 초기화한다
+	if (bKinematicHands)
+	{
+		for (ACapStoneCharacter* Character : ActorCharacters)
+		{
+			Character->SetHandControl(ECapStoneHandControl::KinematicIK);
+		}
+		UE_LOG(LogTemp, Log, TEXT("Kinematic hands: two-bone IK, no ragdoll simulation."));
+	}
+
+	if (ActorCharacters.Num() > LearningAgentsManager->GetMaxAgentNum())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%d characters but LearningAgentsManager MaxAgentNum is %d."),
+			ActorCharacters.Num(), LearningAgentsManager->GetMaxAgentNum());
+	}
+
+	InitHeadlessTraining();
+	InitSimulationRate();
+
+	if (UCapStoneCombatSubsystem* CombatSubsystem = GetWorld()->GetSubsystem<UCapStoneCombatSubsystem>())
+	{
+		CombatSubsystem->SetHitDurationSteps(HitDurationSteps);
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneProfileInterval="), ProfileLogInterval);
+	FCapStoneRLProfiler::Get().SetLogInterval(ProfileLogInterval);
+	FCapStoneRLProfiler::Get().BindPhysicsScene(GetWorld());
+
 	// Make Interactor
 	Interactor = ULearningAgentsInteractor::MakeInteractor(
 		LearningAgentsManager, UMyLearningAgentsInteractor::StaticClass());
@@ -72,6 +141,46 @@ void AMyLearningManager::BeginPlay()
 		UE_LOG(LogTemp, Error, TEXT("Interactor is nullptr."));
 		return;
 	}
+	Cast<UMyLearningAgentsInteractor>(Interactor)->SetAgentSnapshot(&AgentSnapshot);
+
+	// 같은 network 와 snapshot 을 쓰는 inference manager 들은 가중치를 공유한다
+	bool bInitEncoder = Reinitialize;
+	bool bInitPolicy = Reinitialize;
+	bool bInitDecoder = Reinitialize;
+	bool bInitCritic = Reinitialize;
+	const bool bLoadSnapshots = RunInference && !Benchmark.IsEnabled();
+	bool bLoadEncoder = true;
+	bool bLoadPolicy = true;
+	bool bLoadDecoder = true;
+
+	FParse::Value(FCommandLine::Get(), TEXT("CapStonePolicyWatchDir="), PolicySnapshotWatchDirectory.Path);
+	UCapStoneNetworkRegistry* NetworkRegistry = GEngine ? GEngine->GetEngineSubsystem<UCapStoneNetworkRegistry>() : nullptr;
+
+	// hot swap 하는 manager 는 가중치가 바뀌므로 공유하지 않는다
+	if (RunInference && bShareInferenceNetworks && PolicySnapshotWatchDirectory.Path.IsEmpty() && NetworkRegistry)
+	{
+		// 처음 가져간 manager 만 초기화하고 snapshot 을 읽는다
+		auto Acquire = [this, NetworkRegistry](ULearningAgentsNeuralNetwork*& Network, const FString& SnapshotPath, bool& bInOutInit)
+		{
+			bool bCreated = false;
+			if (ULearningAgentsNeuralNetwork* Shared = NetworkRegistry->AcquireNetwork(Network, SnapshotPath, bCreated))
+			{
+				Network = Shared;
+				SharedNetworks.Add(Shared);
+				bInOutInit = bInOutInit && bCreated;
+			}
+			return bCreated;
+		};
+
+		const bool bCreatedEncoder = Acquire(EncoderNN, bLoadSnapshots ? EncoderSnapshot.FilePath : FString(), bInitEncoder);
+		const bool bCreatedPolicy = Acquire(PolicyNN, bLoadSnapshots ? PolicySnapshot.FilePath : FString(), bInitPolicy);
+		const bool bCreatedDecoder = Acquire(DecoderNN, bLoadSnapshots ? DecoderSnapshot.FilePath : FString(), bInitDecoder);
+		Acquire(CriticNN, FString(), bInitCritic);
+
+		bLoadEncoder = bCreatedEncoder;
+		bLoadPolicy = bCreatedPolicy;
+		bLoadDecoder = bCreatedDecoder;
+	}
 
 	// Make Policy
 	Policy = ULearningAgentsPolicy::MakePolicy(
@@ -82,16 +191,25 @@ void AMyLearningManager::BeginPlay()
 		EncoderNN,
 		PolicyNN,
 		DecoderNN,
-		Reinitialize,
-		Reinitialize,
-		Reinitialize,
+		bInitEncoder,
+		bInitPolicy,
+		bInitDecoder,
 		PolicySettings
 	);
-	if(RunInference)
+	if(Policy && bLoadSnapshots)
 	{
-		Policy->GetEncoderNetworkAsset()->LoadNetworkFromSnapshot(EncoderSnapshot);
-		Policy->GetPolicyNetworkAsset()->LoadNetworkFromSnapshot(PolicySnapshot);
-		Policy->GetDecoderNetworkAsset()->LoadNetworkFromSnapshot(DecoderSnapshot);
+		if (bLoadEncoder)
+		{
+			Policy->GetEncoderNetworkAsset()->LoadNetworkFromSnapshot(EncoderSnapshot);
+		}
+		if (bLoadPolicy)
+		{
+			Policy->GetPolicyNetworkAsset()->LoadNetworkFromSnapshot(PolicySnapshot);
+		}
+		if (bLoadDecoder)
+		{
+			Policy->GetDecoderNetworkAsset()->LoadNetworkFromSnapshot(DecoderSnapshot);
+		}
 	}
 	if (!Policy)
 	{
@@ -109,6 +227,32 @@ void AMyLearningManager::BeginPlay()
 	}
 	
 
+	if (RunInference && bAsyncInference)
+	{
+		InferenceScheduler.Init(
+			LearningAgentsManager, Policy, Cast<UMyLearningAgentsInteractor>(Interactor),
+			InferenceFrameBudgetMs);
+	}
+
+	if (RunInference)
+	{
+		FCapStonePolicyHotSwap::FSnapshotNames SnapshotNames;
+		if (!EncoderSnapshot.FilePath.IsEmpty())
+		{
+			SnapshotNames.Encoder = FPaths::GetCleanFilename(EncoderSnapshot.FilePath);
+		}
+		if (!PolicySnapshot.FilePath.IsEmpty())
+		{
+			SnapshotNames.Policy = FPaths::GetCleanFilename(PolicySnapshot.FilePath);
+		}
+		if (!DecoderSnapshot.FilePath.IsEmpty())
+		{
+			SnapshotNames.Decoder = FPaths::GetCleanFilename(DecoderSnapshot.FilePath);
+		}
+
+		PolicyHotSwap.Init(Policy, PolicySnapshotWatchDirectory.Path, SnapshotNames, PolicySnapshotPollInterval);
+	}
+
 	// Make Critic
 	Critic = ULearningAgentsCritic::MakeCritic(
 		LearningAgentsManager,
@@ -117,7 +261,7 @@ void AMyLearningManager::BeginPlay()
 		ULearningAgentsCritic::StaticClass(),
 		TEXT("Critic"),
 		CriticNN,
-		Reinitialize,
+		bInitCritic,
 		CriticSettings
 	);
 	if (!Critic)
@@ -134,16 +278,50 @@ void AMyLearningManager::BeginPlay()
 		UE_LOG(LogTemp, Error, TEXT("TrainingEnv is nullptr."));
 		return;
 	}
+	Cast<UMyLearningAgentsEnv>(TrainingEnv)->SetAgentSnapshot(&AgentSnapshot);
+
+	// inference benchmark 는 trainer process 없이 돌고, training benchmark 는 Python 대신 mock trainer 와 돈다
+	if (Benchmark.IsEnabled() && !Benchmark.IsTraining())
+	{
+		return;
+	}
+	if (Benchmark.IsTraining())
+	{
+		bUseMockTrainer = true;
+	}
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("CapStoneCurriculum")))
+	{
+		bCurriculum = true;
+	}
+
+	// benchmark 는 고정된 난이도로 재야 하므로 curriculum 을 켜지 않는다
+	if (Benchmark.IsEnabled())
+	{
+		bCurriculum = false;
+	}
+	else if (bCurriculum && RunInference)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Curriculum is training only and stays off in inference mode."));
+	}
+	else if (bCurriculum)
+	{
+		Curriculum.Init(ActorCharacters, CurriculumSettings);
+		Curriculum.ApplyOpponentRoles();
+		Cast<UMyLearningAgentsEnv>(TrainingEnv)->SetCurriculum(&Curriculum);
+	}
 	
 	// Make Communicator
-	FLearningAgentsTrainerProcess TrainerProcess = 
-	ULearningAgentsCommunicatorLibrary::SpawnSharedMemoryTrainingProcess(
-		TrainerProcessSettings, SharedMemorySettings
-	);
-	Communicator = 
-	ULearningAgentsCommunicatorLibrary::MakeSharedMemoryCommunicator(
-		TrainerProcess, SharedMemorySettings
-	);
+	if (!MakeCommunicator())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Communicator could not be created."));
+		if (Benchmark.IsEnabled())
+		{
+			// report 없이 끝나야 commandlet 이 실패한 run 으로 본다
+			FPlatformMisc::RequestExit(false, TEXT("AMyLearningManager::BeginPlay"));
+		}
+		return;
+	}
 
 	// Make PPO Trainer
 	PPOTrainer = ULearningAgentsPPOTrainer::MakePPOTrainer(
@@ -160,8 +338,296 @@ void AMyLearningManager::BeginPlay()
 	if (!PPOTrainer)
 	{
 		UE_LOG(LogTemp, Error, TEXT("PPOTrainer is nullptr."));
+		if (Benchmark.IsEnabled())
+		{
+			FPlatformMisc::RequestExit(false, TEXT("AMyLearningManager::BeginPlay"));
+		}
+		return;
+	}
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("CapStoneRecordExperience="), ExperienceLogPath))
+	{
+		bRecordExperience = true;
+	}
+	if (bRecordExperience && !RunInference)
+	{
+		if (ExperienceLogPath.IsEmpty())
+		{
+			ExperienceLogPath = FPaths::ProjectSavedDir() / TEXT("Experience") / (FDateTime::Now().ToString() + TEXT(".cxp"));
+		}
+		ExperienceRecorder.Open(ExperienceLogPath);
+	}
+
+	if (bPipelinedTraining && !RunInference)
+	{
+		Cast<UMyLearningAgentsEnv>(TrainingEnv)->SetDeferResets(true);
+
+		// ProcessExperience 는 physics 가 도는 동안 game thread 에서, 리셋과 다음 action 은 physics 이후에
+		DuringPhysicsTickFunction.Target = this;
+		DuringPhysicsTickFunction.TickGroup = TG_DuringPhysics;
+		DuringPhysicsTickFunction.bCanEverTick = true;
+		DuringPhysicsTickFunction.bRunOnAnyThread = false;
+		DuringPhysicsTickFunction.AddPrerequisite(this, PrimaryActorTick);
+		DuringPhysicsTickFunction.RegisterTickFunction(GetLevel());
+
+		PostPhysicsTickFunction.Target = this;
+		PostPhysicsTickFunction.TickGroup = TG_PostPhysics;
+		PostPhysicsTickFunction.bCanEverTick = true;
+		PostPhysicsTickFunction.AddPrerequisite(this, DuringPhysicsTickFunction);
+		PostPhysicsTickFunction.RegisterTickFunction(GetLevel());
+	}
+}
+
+void AMyLearningManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	InferenceScheduler.Flush();
+	PolicyHotSwap.Flush();
+
+	if (UCapStoneNetworkRegistry* NetworkRegistry = GEngine ? GEngine->GetEngineSubsystem<UCapStoneNetworkRegistry>() : nullptr)
+	{
+		for (ULearningAgentsNeuralNetwork* Network : SharedNetworks)
+		{
+			NetworkRegistry->ReleaseNetwork(Network);
+		}
+	}
+	SharedNetworks.Empty();
+
+	ExperienceRecorder.Close();
+	if (DuringPhysicsTickFunction.IsTickFunctionRegistered())
+	{
+		DuringPhysicsTickFunction.UnRegisterTickFunction();
+	}
+	if (PostPhysicsTickFunction.IsTickFunctionRegistered())
+	{
+		PostPhysicsTickFunction.UnRegisterTickFunction();
+	}
+
+	FCapStoneRLProfiler::Get().UnbindPhysicsScene(GetWorld());
+	RestorePhysicsSettings();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AMyLearningManager::MakeCommunicator()
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("CapStoneMockTrainer")))
+	{
+		bUseMockTrainer = true;
+	}
+
+	FLearningAgentsTrainerProcess TrainerProcess = bUseMockTrainer ?
+	SpawnMockTrainingProcess() :
+	ULearningAgentsCommunicatorLibrary::SpawnSharedMemoryTrainingProcess(
+		TrainerProcessSettings, SharedMemorySettings
+	);
+	if (bUseMockTrainer && !TrainerProcess.TrainerProcess.IsValid())
+	{
+		return false;
+	}
+	Communicator = 
+	ULearningAgentsCommunicatorLibrary::MakeSharedMemoryCommunicator(
+		TrainerProcess, SharedMemorySettings
+	);
+	return true;
+}
+
+FLearningAgentsTrainerProcess AMyLearningManager::SpawnMockTrainingProcess() const
+{
+	FString MockTrainerPath = FPaths::Combine(FPaths::ProjectDir(), TEXT("Binaries"), FPlatformProcess::GetBinariesSubdirectory(),
+		FString(TEXT("CapStoneMockTrainer")) + (PLATFORM_WINDOWS ? TEXT(".exe") : TEXT("")));
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneMockTrainerPath="), MockTrainerPath);
+	MockTrainerPath = FPaths::ConvertRelativePathToFull(MockTrainerPath);
+
+	if (!FPaths::FileExists(MockTrainerPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Mock trainer not found at %s. Build the CapStoneMockTrainer target or pass -CapStoneMockTrainerPath=."), *MockTrainerPath);
+		return FLearningAgentsTrainerProcess();
+	}
+
+	// 엔진이 Python 을 띄우는 자리에 mock trainer 를 넣는다.
+	// 인자는 SpawnSharedMemoryTrainingProcess 와 같고 mock trainer 는 앞에 붙는 script 경로를 건너뛴다.
+	// Mock trainer 는 controls block 하나만 보므로 ProcessNum 은 1 로 고정한다.
+	FLearningAgentsTrainerProcess TrainerProcess;
+	TrainerProcess.TrainerProcess = MakeShared<UE::Learning::FSharedMemoryTrainerServerProcess>(
+		SharedMemorySettings.TaskName.ToString(),
+		SharedMemorySettings.CustomTrainerModulePath,
+		SharedMemorySettings.TrainerFileName,
+		MockTrainerPath,
+		UE::Learning::Trainer::GetPythonContentPath(TrainerProcessSettings.GetEditorEnginePath()),
+		TrainerProcessSettings.GetIntermediatePath(),
+		1,
+		SharedMemorySettings.Timeout);
+
+	UE_LOG(LogTemp, Log, TEXT("Training against mock trainer %s."), *MockTrainerPath);
+	return TrainerProcess;
+}
+
+int32 AMyLearningManager::MakeCharacterSeed(int32 ArenaIndex, int32 TeamID) const
+{
+	return (int32)HashCombine(GetTypeHash(RunSeed), GetTypeHash(ArenaIndex * 2 + TeamID));
+}
+
+void AMyLearningManager::SpawnArenas()
+{
+	if (ArenaNum <= 0)
+	{
+		return;
+	}
+	if (!AgentClass || !OpponentClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("AgentClass and OpponentClass must be set to spawn arenas."));
+		return;
+	}
+
+	const int32 ColumnNum = FMath::CeilToInt32(FMath::Sqrt((float)ArenaNum));
+	const FVector GridOrigin = GetActorLocation();
+
+	FActorSpawnParameters ArenaSpawnParams;
+	ArenaSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<ACapStoneCharacter*> SpawnedCharacters;
+	SpawnedCharacters.Reserve(ArenaNum * 2);
+
+	for (int32 ArenaIndex = 0; ArenaIndex < ArenaNum; ++ArenaIndex)
+	{
+		const FVector Origin = GridOrigin + FVector(
+			(ArenaIndex % ColumnNum) * ArenaSpacing, (ArenaIndex / ColumnNum) * ArenaSpacing, 0.f);
+
+		if (ArenaTemplate)
+		{
+			GetWorld()->SpawnActor<AActor>(ArenaTemplate, Origin, FRotator::ZeroRotator, ArenaSpawnParams);
+		}
+
+		// 0 번 팀이 agent, 1 번 팀이 opponent, 서로 마주 보게 생성
+		for (int32 Team = 0; Team < 2; ++Team)
+		{
+			const float Side = Team == 0 ? -1.f : 1.f;
+			const FTransform SpawnTransform(
+				FRotator(0.f, Team == 0 ? 0.f : 180.f, 0.f),
+				Origin + FVector(Side * ArenaSpawnDistance * 0.5f, 0.f, ArenaSpawnHeight));
+
+			ACapStoneCharacter* Character = GetWorld()->SpawnActorDeferred<ACapStoneCharacter>(
+				Team == 0 ? AgentClass : OpponentClass, SpawnTransform, this, nullptr,
+				ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+			if (!Character)
+			{
+				continue;
+			}
+
+			Character->AutoPossessAI = EAutoPossessAI::Spawned;
+			Character->InitArena(ArenaIndex, Team, Origin, LearningAgentsManager);
+			if (bKinematicHands)
+			{
+				Character->SetHandControl(ECapStoneHandControl::KinematicIK);
+			}
+			Character->SetRandomSeed(MakeCharacterSeed(ArenaIndex, Team));
+			Character->AddTickPrerequisiteActor(this);
+			Character->FinishSpawning(SpawnTransform);
+
+			ActorCharacters.Add(Character);
+			SpawnedCharacters.Add(Character);
+		}
+	}
+
+	// 모든 arena 가 생긴 뒤에 적 정보를 채우고 첫 리셋을 한다. agent 가 먼저 생성되면 상대가 없어 리셋이 건너뛰어진다
+	for (ACapStoneCharacter* Character : SpawnedCharacters)
+	{
+		Character->BeginArenaEpisode();
+	}
+
+	ArenaCharacters = MoveTemp(SpawnedCharacters);
+	UE_LOG(LogTemp, Log, TEXT("Spawned %d arenas (%d characters)."), ArenaNum, ArenaCharacters.Num());
+}
+
+void AMyLearningManager::InitHeadlessTraining()
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("CapStoneHeadless")) || !FApp::CanEverRender())
+	{
+		bHeadlessTraining = true;
+	}
+	if (!bHeadlessTraining)
+	{
+		return;
+	}
+
+	// 프레임 속도와 상관없이 고정된 시뮬레이션 시간으로 최대한 빠르게 돈다
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / HeadlessStepRate);
+	GEngine->bSmoothFrameRate = false;
+	GEngine->bUseFixedFrameRate = false;
+
+	for (ACapStoneCharacter* Character : ActorCharacters)
+	{
+		Character->SetHeadlessMode(true);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Headless training: fixed step %.4fs, rendering %s"),
+		FApp::GetFixedDeltaTime(), FApp::CanEverRender() ? TEXT("on") : TEXT("off"));
+}
+
+void AMyLearningManager::InitSimulationRate()
+{
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneActionRepeat="), ActionRepeat);
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneSubSteps="), PhysicsSubStepNum);
+	FParse::Value(FCommandLine::Get(), TEXT("CapStoneTimeDilation="), TimeDilation);
+	ActionRepeat = FMath::Max(ActionRepeat, 1);
+	PhysicsSubStepNum = FMath::Max(PhysicsSubStepNum, 1);
+
+	// pipelined 학습은 결정 직후 프레임에 experience 를 처리하므로 action 을 두 프레임 이상 유지해야 한다
+	if (bPipelinedTraining && !RunInference && ActionRepeat < 2)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Pipelined training needs ActionRepeat >= 2, raising ActionRepeat from %d to 2."), ActionRepeat);
+		ActionRepeat = 2;
+	}
+
+	if (PhysicsSubStepNum > 1)
+	{
+		// 한 tick 의 시뮬레이션 시간을 PhysicsSubStepNum 개로 나눠서 푼다. sub-step 길이는 Tick 에서 실제 DeltaTime 으로 맞춘다
+		UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+		bSavedSubstepping = PhysicsSettings->bSubstepping;
+		SavedMaxSubsteps = PhysicsSettings->MaxSubsteps;
+		SavedMaxSubstepDeltaTime = PhysicsSettings->MaxSubstepDeltaTime;
+		bPhysicsSettingsOverridden = true;
+
+		PhysicsSettings->bSubstepping = true;
+		PhysicsSettings->MaxSubsteps = PhysicsSubStepNum;
+	}
+
+	if (!FMath::IsNearlyEqual(TimeDilation, 1.f))
+	{
+		AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+		WorldSettings->MaxGlobalTimeDilation = FMath::Max(WorldSettings->MaxGlobalTimeDilation, TimeDilation);
+		WorldSettings->SetTimeDilation(TimeDilation);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Action repeat %d, physics sub-steps %d, time dilation %.2f"),
+		ActionRepeat, PhysicsSubStepNum, TimeDilation);
+}
+
+void AMyLearningManager::UpdatePhysicsSubStep(float DeltaTime)
+{
+	if (!bPhysicsSettingsOverridden || DeltaTime <= 0.f)
+	{
+		return;
+	}
+
+	// DeltaTime 은 이미 time dilation 이 적용된 이번 프레임 physics 시간이다.
+	// 조금 늘려서 반올림 때문에 sub-step 이 하나 더 생기지 않게 한다
+	UPhysicsSettings::Get()->MaxSubstepDeltaTime = DeltaTime / PhysicsSubStepNum * 1.001f;
+}
+
+void AMyLearningManager::RestorePhysicsSettings()
+{
+	if (!bPhysicsSettingsOverridden)
+	{
 		return;
 	}
+
+	UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+	PhysicsSettings->bSubstepping = bSavedSubstepping;
+	PhysicsSettings->MaxSubsteps = SavedMaxSubsteps;
+	PhysicsSettings->MaxSubstepDeltaTime = SavedMaxSubstepDeltaTime;
+	bPhysicsSettingsOverridden = false;
 }
 
 // Called every frame
@@ -169,13 +635,242 @@ void AMyLearningManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	const double StepStartTime = FPlatformTime::Seconds();
+
+	UpdatePhysicsSubStep(DeltaTime);
+	PolicyHotSwap.Tick(DeltaTime);
+
+	FCapStoneRLProfiler::Get().BeginStep();
+	{
+		CAPSTONE_RL_SCOPE(Step);
+		StepAgents();
+	}
+	// pipelined 스텝은 PostPhysicsTick 에서 끝난다
+	if (!bPipelinedStepPending)
+	{
+		FCapStoneRLProfiler::Get().EndStep();
+	}
+
+	if (Benchmark.IsEnabled())
+	{
+		Benchmark.AddStep(FPlatformTime::Seconds() - StepStartTime);
+		Benchmark.TryFinish(ArenaCharacters, ArenaCharacters.Num());
+	}
+}
+
+void AMyLearningManager::FlushAgentTasks()
+{
+	InferenceScheduler.Flush();
+}
+
+void AMyLearningManager::RequestPolicySnapshotLoad(
+	const FFilePath& InEncoderSnapshot, const FFilePath& InPolicySnapshot, const FFilePath& InDecoderSnapshot)
+{
+	if (!RunInference)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Policy snapshots can only be swapped in inference mode."));
+		return;
+	}
+	// 공유 network 에 로드하면 같은 registry 를 쓰는 다른 manager 의 정책까지 바뀐다
+	if (SharedNetworks.Num() > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Policy snapshots cannot be swapped while this manager uses shared inference networks. ")
+			TEXT("Turn off bShareInferenceNetworks to hot-swap."));
+		return;
+	}
+	PolicyHotSwap.RequestLoad(InEncoderSnapshot.FilePath, InPolicySnapshot.FilePath, InDecoderSnapshot.FilePath);
+}
+
+void AMyLearningManager::StepAgents()
+{
+	// 지난 physics 스텝에서 모인 무기 hit 을 한 번에 처리
+	if (UCapStoneCombatSubsystem* CombatSubsystem = GetWorld()->GetSubsystem<UCapStoneCombatSubsystem>())
+	{
+		CombatSubsystem->ResolveHits();
+	}
+
+	// 스텝마다 한 번 적 정보 갱신
+	if (UCapStoneEnemySubsystem* EnemySubsystem = GetWorld()->GetSubsystem<UCapStoneEnemySubsystem>())
+	{
+		EnemySubsystem->RefreshEnemyInformation();
+	}
+
+	AgentSnapshot.Update(ActorCharacters, LearningAgentsManager);
+
+	// 결정 사이의 tick 은 마지막 이동, 회전만 유지
+	const bool bDecisionTick = TickCount % ActionRepeat == 0;
+	++TickCount;
+	if (!bDecisionTick)
+	{
+		Cast<UMyLearningAgentsInteractor>(Interactor)->HoldLastCommands();
+		return;
+	}
+
+	CAPSTONE_RL_SCOPE(RunTraining);
 	if(RunInference)
 	{
-		Policy->RunInference();
+		// worker 가 network 를 읽는 중이 아닐 때만 가중치를 바꾼다
+		if (!InferenceScheduler.IsBusy())
+		{
+			PolicyHotSwap.TryApply();
+		}
+
+		const TBitArray<>* DecisionMask = nullptr;
+		if (bDecisionLOD)
+		{
+			DecisionLOD.Update(GetWorld(), AgentSnapshot, DecisionLODSettings);
+			DecisionMask = &DecisionLOD.GetDecisionMask();
+		}
+
+		if (InferenceScheduler.IsInitialized())
+		{
+			InferenceScheduler.SetEligibleMask(DecisionMask);
+			InferenceScheduler.Tick();
+		}
+		else if (DecisionMask)
+		{
+			// 이번 프레임에 결정하는 agent 만 gather, 평가, 적용하고 나머지는 이동, 회전만 유지한다
+			const UE::Learning::FIndexSet DecisionSet(DecisionLOD.GetDecisionAgentIds());
+			UMyLearningAgentsInteractor* MyInteractor = Cast<UMyLearningAgentsInteractor>(Interactor);
+			if (DecisionLOD.GetDecisionAgentIds().Num() > 0)
+			{
+				MyInteractor->GatherObservations(DecisionSet);
+				Policy->EncodeObservations(DecisionSet);
+				Policy->EvaluatePolicy(DecisionSet);
+				Policy->DecodeAndSampleActions(0.f, DecisionSet);
+				MyInteractor->PerformActions(DecisionSet);
+			}
+			MyInteractor->HoldLastCommands(DecisionMask);
+		}
+		else
+		{
+			Policy->RunInference();
+		}
+	}
+	else if (!PPOTrainer)
+	{
+		// BeginPlay 에서 trainer 를 만들지 못했다
+		return;
+	}
+	else if (PostPhysicsTickFunction.IsTickFunctionRegistered())
+	{
+		BeginPipelinedStep();
 	}
 	else
 	{
 		PPOTrainer->RunTraining(
 			PPOTrainingSettings, TrainingGameSettings, true, true);
+
+		ExperienceRecorder.RecordStep(
+			Cast<UMyLearningAgentsInteractor>(Interactor), Cast<UMyLearningAgentsEnv>(TrainingEnv), AgentSnapshot);
+
+		// 이번 스텝의 리셋에서 stage 가 바뀐 opponent 는 다음 RunTraining 전에 agent 등록을 바꾼다
+		Curriculum.ApplyOpponentRoles();
 	}
-}
\ No newline at end of file
+}
+
+void AMyLearningManager::BeginPipelinedStep()
+{
+	if (!PPOTrainer->IsTraining())
+	{
+		PPOTrainer->BeginTraining(PPOTrainingSettings, TrainingGameSettings, true);
+		if (!PPOTrainer->IsTraining())
+		{
+			return;
+		}
+	}
+
+	// 지난 action 의 결과로 reward, completion 을 모으고 experience 처리는 DuringPhysicsTick 에서 physics 와 겹쳐서 돌린다
+	if (bHasExperience)
+	{
+		TrainingEnv->GatherCompletions();
+		TrainingEnv->GatherRewards();
+		bExperiencePending = true;
+	}
+
+	bPipelinedStepPending = true;
+}
+
+void AMyLearningManager::DuringPhysicsTick(float DeltaTime)
+{
+	if (!bExperiencePending)
+	{
+		return;
+	}
+	bExperiencePending = false;
+
+	// trainer 를 기다리는 시간이 physics 와 겹친다. 리셋은 env 가 physics 이후까지 미뤄 둔다
+	CAPSTONE_RL_SCOPE(ProcessExperience);
+	PPOTrainer->ProcessExperience(true);
+}
+
+void AMyLearningManager::EndPipelinedStep()
+{
+	if (PPOTrainer->HasTrainingFailed())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Training failed, stopping pipelined training."));
+		DuringPhysicsTickFunction.UnRegisterTickFunction();
+		PostPhysicsTickFunction.UnRegisterTickFunction();
+		return;
+	}
+
+	// ProcessExperience 가 요청한 리셋을 physics 가 끝난 뒤에 모두 처리
+	Cast<UMyLearningAgentsEnv>(TrainingEnv)->FlushPendingResets();
+	Curriculum.ApplyOpponentRoles();
+
+	// observation 은 physics 이후 상태를 봐야 하므로 적 정보와 스냅샷을 다시 채운다
+	if (UCapStoneEnemySubsystem* EnemySubsystem = GetWorld()->GetSubsystem<UCapStoneEnemySubsystem>())
+	{
+		EnemySubsystem->RefreshEnemyInformation(true);
+	}
+	AgentSnapshot.Update(ActorCharacters, LearningAgentsManager);
+
+	{
+		CAPSTONE_RL_SCOPE(RunTraining);
+		Policy->RunInference(TrainingActionNoiseScale);
+	}
+	bHasExperience = true;
+
+	ExperienceRecorder.RecordStep(
+		Cast<UMyLearningAgentsInteractor>(Interactor), Cast<UMyLearningAgentsEnv>(TrainingEnv), AgentSnapshot);
+}
+
+void AMyLearningManager::PostPhysicsTick(float DeltaTime)
+{
+	if (!bPipelinedStepPending)
+	{
+		return;
+	}
+	bPipelinedStepPending = false;
+
+	EndPipelinedStep();
+	FCapStoneRLProfiler::Get().EndStep();
+}
+
+void FCapStoneDuringPhysicsTickFunction::ExecuteTick(
+	float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && IsValid(Target))
+	{
+		Target->DuringPhysicsTick(DeltaTime);
+	}
+}
+
+FString FCapStoneDuringPhysicsTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("AMyLearningManager::DuringPhysicsTick[%s]"), *GetNameSafe(Target));
+}
+
+void FCapStonePostPhysicsTickFunction::ExecuteTick(
+	float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && IsValid(Target))
+	{
+		Target->PostPhysicsTick(DeltaTime);
+	}
+}
+
+FString FCapStonePostPhysicsTickFunction::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("AMyLearningManager::PostPhysicsTick[%s]"), *GetNameSafe(Target));
+}
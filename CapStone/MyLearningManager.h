@@ -9,17 +9,69 @@
 #include "LearningAgentsTrainer.h"
 #include "LearningAgentsPPOTrainer.h"
 
+#include "CapStoneAgentSnapshot.h"
+#include "CapStoneBenchmark.h"
+#include "CapStoneInferenceScheduler.h"
+#include "CapStoneDecisionLOD.h"
+#include "CapStoneCurriculum.h"
+#include "CapStoneExperienceLog.h"
+#include "CapStonePolicyHotSwap.h"
+
 #include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
 #include "GameFramework/Actor.h"
 #include "MyLearningManager.generated.h"
 
 class ACapStoneCharacter;
+class AMyLearningManager;
 class ULearningAgentsInteractor;
 // class ULearningAgentsPolicy;
 // class ULearningAgentsCritic;
 class ULearningAgentsTrainingEnvironment;
 class ULearningAgentsNeuralNetwork;
 
+/** Runs ProcessExperience of a pipelined training step on the game thread while physics simulates */
+USTRUCT()
+struct FCapStoneDuringPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	AMyLearningManager* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCapStoneDuringPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FCapStoneDuringPhysicsTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/** Runs the second half of a pipelined training step after physics */
+USTRUCT()
+struct FCapStonePostPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	AMyLearningManager* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCapStonePostPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FCapStonePostPhysicsTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
 UCLASS()
 class CAPSTONE_API AMyLearningManager : public AActor
 {
@@ -36,16 +88,172 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	/** Inference only, and refused while the networks are shared: reads the three snapshots on a worker task and swaps them in at the next decision step */
+	UFUNCTION(BlueprintCallable, Category = "Snapshot")
+	void RequestPolicySnapshotLoad(const FFilePath& InEncoderSnapshot, const FFilePath& InPolicySnapshot, const FFilePath& InDecoderSnapshot);
+
+	/** Waits for async inference. Call before adding or removing agents from LearningAgentsManager. */
+	void FlushAgentTasks();
+
+	/** TG_DuringPhysics, only registered for pipelined training */
+	void DuringPhysicsTick(float DeltaTime);
+
+	/** TG_PostPhysics, only registered for pipelined training */
+	void PostPhysicsTick(float DeltaTime);
+
 private:
+	/** 한 스텝: 리셋, hit, 적 정보, 스냅샷 갱신 후 RunTraining 또는 RunInference */
+	void StepAgents();
+
+	/** Pre-physics: gathers rewards and completions for the experience processed during physics */
+	void BeginPipelinedStep();
+
+	/** Post-physics: flushes the resets ProcessExperience asked for and runs inference for the next step */
+	void EndPipelinedStep();
+
+	/** RunSeed 와 arena index 로 캐릭터마다 다른 seed 를 만든다 */
+	int32 MakeCharacterSeed(int32 ArenaIndex, int32 TeamID) const;
+
+	/** ArenaNum 개의 arena 를 grid 로 생성하고 각 arena 의 agent, opponent 를 이 manager 에 등록한다 */
+	void SpawnArenas();
+
+	/** Shared memory trainer process 를 띄우고 연결한다. bUseMockTrainer 이면 Python 대신 mock trainer */
+	bool MakeCommunicator();
+
+	/** With bUseMockTrainer: starts CapStoneMockTrainer where SpawnSharedMemoryTrainingProcess would start Python */
+	FLearningAgentsTrainerProcess SpawnMockTrainingProcess() const;
+
+	/** ActionRepeat, PhysicsSubStepNum, TimeDilation 을 적용한다 */
+	void InitSimulationRate();
+
+	/** 이번 tick 의 DeltaTime 을 PhysicsSubStepNum 개로 나누도록 sub-step 길이를 맞춘다 */
+	void UpdatePhysicsSubStep(float DeltaTime);
+
+	/** InitSimulationRate 가 바꾼 project physics settings 를 원래 값으로 돌린다 */
+	void RestorePhysicsSettings();
+
+	/** -CapStoneHeadless, -nullrhi 또는 bHeadlessTraining 이면 debug drawing, 카메라를 끄고 고정 timestep 으로 돈다 */
+	void InitHeadlessTraining();
+
 	TArray<ACapStoneCharacter*> ActorCharacters;
+
+	// SpawnArenas 가 만든 캐릭터만, benchmark 는 이 수로 기록한다
+	TArray<ACapStoneCharacter*> ArenaCharacters;
+
+	/** Number of arenas spawned at BeginPlay. 0 keeps only the hand-placed arenas. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0"), Category = "Arena")
+	int32 ArenaNum = 0;
+
+	/** Actor spawned at each arena origin (floor, walls). Optional. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Arena")
+	TSubclassOf<AActor> ArenaTemplate;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Arena")
+	TSubclassOf<ACapStoneCharacter> AgentClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Arena")
+	TSubclassOf<ACapStoneCharacter> OpponentClass;
+
+	/** Distance between neighbouring arena origins. Keep it well above MaxRadius * 2. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Arena")
+	float ArenaSpacing = 3000.f;
+
+	/** Agent and opponent start this far apart, centred on the arena origin */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Arena")
+	float ArenaSpawnDistance = 300.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Arena")
+	float ArenaSpawnHeight = 100.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Training")
+	bool bHeadlessTraining = false;
+
+	/** Seeds every character's reset random stream together with its arena index. 0 picks one from the clock; the seed in use is logged. -CapStoneSeed= overrides it. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Training")
+	int32 RunSeed = 0;
+
+	/** Every character uses ECapStoneHandControl::KinematicIK instead of the ragdoll and physics handles. Cheap early training; turn off for fine-tuning. -CapStoneKinematicHands turns it on. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Training")
+	bool bKinematicHands = false;
+
+	/**
+	 * A decision is held for this many ticks. Movement and look input are held in between, hand steps are applied once per decision.
+	 * At least 2 with bPipelinedTraining.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "1"), Category = "Training")
+	int32 ActionRepeat = 1;
+
+	/** Physics sub-steps per engine tick. 1 leaves the project physics settings untouched. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "1"), Category = "Training")
+	int32 PhysicsSubStepNum = 1;
+
+	/** Simulated seconds per wall-clock second. Use with PhysicsSubStepNum to keep physics stable. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0.1"), Category = "Training")
+	float TimeDilation = 1.f;
+
+	// UPhysicsSettings 는 CDO 라 EndPlay 에서 원래 값으로 돌려 놓는다
+	bool bPhysicsSettingsOverridden = false;
+	bool bSavedSubstepping = false;
+	int32 SavedMaxSubsteps = 0;
+	float SavedMaxSubstepDeltaTime = 0.f;
+
+	int32 TickCount = 0;
+
+	/** Training only: each arena moves through CurriculumSettings.Stages by its agent's success rate. -CapStoneCurriculum turns it on. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Curriculum")
+	bool bCurriculum = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bCurriculum"), Category = "Curriculum")
+	FCapStoneCurriculumSettings CurriculumSettings;
+
+	FCapStoneCurriculum Curriculum;
+
+	/** Steps an agent stays in the hit state after landing a weapon hit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "1"), Category = "Training")
+	int32 HitDurationSteps = 6;
+
+	/** Logs steps/sec and per-phase percentiles every this many steps. 0 is off. -CapStoneProfileInterval= overrides it. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0"), Category = "Profiling")
+	int32 ProfileLogInterval = 0;
+
+	/** Simulated steps per second when running headless. The engine does not wait for wall-clock time. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "1"), Category = "Training")
+	float HeadlessStepRate = 30.f;
+
+	// -CapStoneBenchmarkReport= 로 켜지는 처리량 측정
+	FCapStoneBenchmark Benchmark;
+
+	// 스텝마다 한 번 채워서 interactor, env 가 같이 읽는 agent 상태
+	FCapStoneAgentSnapshot AgentSnapshot;
 	
 	bool RunInference = false;
 	bool Reinitialize = true;
 
+	/** Inference only: evaluate the networks on a worker task and apply the actions on the next frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Inference")
+	bool bAsyncInference = true;
+
+	/** Game-thread milliseconds per frame for action decode and observation gather. Over budget, agents take turns. 0 is unlimited. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0"), Category = "Inference")
+	float InferenceFrameBudgetMs = 2.f;
+
+	FCapStoneInferenceScheduler InferenceScheduler;
+
+	/** Inference only: far, offscreen and dead agents decide less often and hold their last command in between */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Inference")
+	bool bDecisionLOD = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bDecisionLOD"), Category = "Inference")
+	FCapStoneDecisionLODSettings DecisionLODSettings;
+
+	FCapStoneDecisionLOD DecisionLOD;
+
 	// Interactor
 	ULearningAgentsInteractor* Interactor;
 
@@ -58,6 +266,22 @@ private:
 	FFilePath PolicySnapshot;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Snapshot")
 	FFilePath DecoderSnapshot;
+
+	/** Inference only: new snapshots written here (same file names as above) are swapped in while playing. -CapStonePolicyWatchDir= overrides it. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Snapshot")
+	FDirectoryPath PolicySnapshotWatchDirectory;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0.1"), Category = "Snapshot")
+	float PolicySnapshotPollInterval = 2.f;
+
+	FCapStonePolicyHotSwap PolicyHotSwap;
+
+	/** Inference only: managers using the same networks and snapshots share one read-only copy of the weights (UCapStoneNetworkRegistry). Off when PolicySnapshotWatchDirectory is set, and RequestPolicySnapshotLoad is refused while the copy is shared. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "NeuralNetwork")
+	bool bShareInferenceNetworks = true;
+
+	// registry 에서 받은 network, EndPlay 에서 돌려준다
+	TArray<ULearningAgentsNeuralNetwork*> SharedNetworks;
 	
 	// UPROPERTY(EditAnywhere, Category = "NeuralNetwork")
 	// FString EncoderNNPath = "";
@@ -95,6 +319,43 @@ private:
 	FLearningAgentsCommunicator Communicator;
 	FLearningAgentsTrainerProcessSettings TrainerProcessSettings;
 	FLearningAgentsSharedMemoryCommunicatorSettings SharedMemorySettings;
+
+	/**
+	 * Trains against the native CapStoneMockTrainer instead of the Python trainer to measure game-side throughput.
+	 * -CapStoneMockTrainer sets it, -CapStoneMockTrainerPath= overrides <Project>/Binaries/<Platform>/CapStoneMockTrainer.
+	 * The policy does not learn.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Training")
+	bool bUseMockTrainer = false;
+
+	/**
+	 * Training only: ProcessExperience (trainer I/O and the policy update) runs on the game thread in TG_DuringPhysics,
+	 * so waiting for the trainer overlaps the physics simulation. Its resets are applied after physics.
+	 * Needs ActionRepeat >= 2 so every action is simulated at least one frame before its reward is read.
+	 * A lower ActionRepeat (including -CapStoneActionRepeat=1) is raised to 2 with a warning when this is on.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Training")
+	bool bPipelinedTraining = false;
+
+	/** Action noise passed to RunInference when pipelined training samples actions itself */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bPipelinedTraining"), Category = "Training")
+	float TrainingActionNoiseScale = 1.f;
+
+	/** Training only: appends every agent's observation, action, reward and completion to ExperienceLogPath */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"), Category = "Experience")
+	bool bRecordExperience = false;
+
+	/** Empty uses Saved/Experience/<date>.cxp. -CapStoneRecordExperience=<path> turns recording on. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bRecordExperience"), Category = "Experience")
+	FString ExperienceLogPath;
+
+	FCapStoneExperienceRecorder ExperienceRecorder;
+
+	FCapStoneDuringPhysicsTickFunction DuringPhysicsTickFunction;
+	FCapStonePostPhysicsTickFunction PostPhysicsTickFunction;
+	bool bPipelinedStepPending = false;
+	bool bExperiencePending = false;
+	bool bHasExperience = false;
 	
 	// PPO Trainer
 	ULearningAgentsPPOTrainer* PPOTrainer;
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MockTrainer.h"
+
+#include "RequiredProgramMainCPPInclude.h"
+
+IMPLEMENT_APPLICATION(CapStoneMockTrainer, "CapStoneMockTrainer");
+
+INT32_MAIN_INT32_ARGC_TCHAR_ARGV()
+{
+	FTaskTagScope Scope(ETaskTag::EGameThread);
+	ON_SCOPE_EXIT
+	{
+		FEngineLoop::AppPreExit();
+		FEngineLoop::AppExit();
+	};
+
+	const FString CommandLine = FCommandLine::BuildFromArgV(nullptr, ArgC, ArgV, nullptr);
+	if (GEngineLoop.PreInit(*CommandLine) != 0)
+	{
+		return 1;
+	}
+
+	FMockTrainer Trainer;
+	if (!Trainer.ParseCommandLine(*CommandLine) || !Trainer.Open())
+	{
+		return 1;
+	}
+
+	return Trainer.Run();
+}
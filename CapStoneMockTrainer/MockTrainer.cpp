@@ -0,0 +1,421 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MockTrainer.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogMockTrainer, Log, All);
+
+namespace
+{
+	// Network 앞쪽의 header 는 건드리지 않는다 (Random 모드)
+	constexpr int32 NetworkHeaderByteNum = 16;
+
+	// 신호를 기다릴 때 이 시간 이상 바쁘게 돌지 않고 잠깐 쉰다
+	constexpr double SpinSeconds = 0.001;
+
+	// 이 시간 동안 아무 신호가 없으면 게임이 죽었다고 본다
+	constexpr double IdleTimeoutSeconds = 600.0;
+
+	/** VectorDimNum of Key, either one object or an array of objects (one per observation, action, ... set). 0 when missing. */
+	int32 ReadVectorDimNum(const FJsonObject& Buffer, const TCHAR* Key)
+	{
+		using namespace MockTrainerProtocol;
+
+		const TSharedPtr<FJsonObject>* Object = nullptr;
+		if (Buffer.TryGetObjectField(Key, Object))
+		{
+			return (*Object)->GetIntegerField(VectorDimNumKey);
+		}
+
+		int32 DimNum = 0;
+		const TArray<TSharedPtr<FJsonValue>>* Array = nullptr;
+		if (Buffer.TryGetArrayField(Key, Array))
+		{
+			for (const TSharedPtr<FJsonValue>& Value : *Array)
+			{
+				const TSharedPtr<FJsonObject> Entry = Value->AsObject();
+				DimNum += Entry.IsValid() ? Entry->GetIntegerField(VectorDimNumKey) : 0;
+			}
+		}
+		return DimNum;
+	}
+
+	/** Sum of every 8-byte word, so the compiler cannot drop the read and the game's writes are really pulled in */
+	uint64 TouchBytes(const uint8* Data, int64 ByteNum)
+	{
+		uint64 Sum = 0;
+		int64 Offset = 0;
+		for (; Offset + 8 <= ByteNum; Offset += 8)
+		{
+			uint64 Word;
+			FMemory::Memcpy(&Word, Data + Offset, sizeof(Word));
+			Sum += Word;
+		}
+		for (; Offset < ByteNum; ++Offset)
+		{
+			Sum += Data[Offset];
+		}
+		return Sum;
+	}
+}
+
+FMockTrainer::~FMockTrainer()
+{
+	UnmapRegion(ReplayBuffer);
+	UnmapRegion(Network);
+	UnmapRegion(Controls);
+}
+
+bool FMockTrainer::ParseCommandLine(const TCHAR* CommandLine)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	FCommandLine::Parse(CommandLine, Tokens, Switches);
+
+	// 엔진이 Python 대신 띄우면 trainer script 경로가 먼저 온다
+	if (Tokens.Num() > 0 && Tokens[0].EndsWith(TEXT(".py")))
+	{
+		Tokens.RemoveAt(0);
+	}
+
+	// <TaskName> SharedMemory <ControlsGuid> <ProcessNum> <ConfigPath>
+	if (Tokens.Num() < 5 || Tokens[1] != TEXT("SharedMemory"))
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Usage: CapStoneMockTrainer [<TrainerScript.py>] <TaskName> SharedMemory <ControlsGuid> <ProcessNum> <ConfigPath> [-fixed|-random] [-report=<seconds>] [-seed=<n>]"));
+		return false;
+	}
+
+	TaskName = Tokens[0];
+	if (!FGuid::Parse(Tokens[2], ControlsGuid))
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Invalid controls guid: %s"), *Tokens[2]);
+		return false;
+	}
+	ProcessNum = FCString::Atoi(*Tokens[3]);
+	ConfigPath = Tokens[4];
+
+	// 신호는 첫 번째 controls block 에서만 주고받으므로 게임 process 하나만 받는다
+	if (ProcessNum != 1)
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("The mock trainer serves one game process, got ProcessNum %s."), *Tokens[3]);
+		return false;
+	}
+
+	WeightMode = FParse::Param(CommandLine, TEXT("random")) ? EWeightMode::Random : EWeightMode::Fixed;
+	FParse::Value(CommandLine, TEXT("-report="), ReportInterval);
+	FParse::Value(CommandLine, TEXT("-seed="), Seed);
+	Random.Initialize(Seed);
+
+	return true;
+}
+
+bool FMockTrainer::MapRegion(const FGuid& Guid, int64 ByteNum, FRegion& OutRegion) const
+{
+	OutRegion.Region = FPlatformMemory::MapNamedSharedMemoryRegion(
+		MockTrainerProtocol::MakeRegionName(Guid), false,
+		FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write,
+		ByteNum);
+
+	if (!OutRegion.Region)
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Failed to map shared memory %s (%lld bytes)."), *Guid.ToString(), ByteNum);
+		return false;
+	}
+
+	OutRegion.Data = static_cast<uint8*>(OutRegion.Region->GetAddress());
+	OutRegion.ByteNum = ByteNum;
+	return true;
+}
+
+void FMockTrainer::UnmapRegion(FRegion& Region) const
+{
+	if (Region.Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region.Region);
+	}
+	Region = FRegion();
+}
+
+bool FMockTrainer::LoadConfig()
+{
+	using namespace MockTrainerProtocol;
+
+	FString ConfigString;
+	if (!FFileHelper::LoadFileToString(ConfigString, *ConfigPath))
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Failed to read config %s"), *ConfigPath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Config;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(ConfigString), Config) || !Config.IsValid())
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Failed to parse config %s"), *ConfigPath);
+		return false;
+	}
+
+	// policy network 하나, replay buffer 하나만 본다
+	const TArray<TSharedPtr<FJsonValue>>* Networks = nullptr;
+	const TArray<TSharedPtr<FJsonValue>>* ReplayBuffers = nullptr;
+	if (!Config->TryGetArrayField(NetworksKey, Networks) || Networks->Num() == 0 ||
+		!Config->TryGetArrayField(ReplayBuffersKey, ReplayBuffers) || ReplayBuffers->Num() == 0)
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Config has no network or replay buffer."));
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject> NetworkObject = (*Networks)[0]->AsObject();
+	const TSharedPtr<FJsonObject> BufferObject = (*ReplayBuffers)[0]->AsObject();
+	if (!NetworkObject.IsValid() || !BufferObject.IsValid())
+	{
+		return false;
+	}
+
+	FGuid NetworkGuid;
+	FGuid BufferGuid;
+	if (!FGuid::Parse(NetworkObject->GetStringField(GuidKey), NetworkGuid) ||
+		!FGuid::Parse(BufferObject->GetStringField(GuidKey), BufferGuid))
+	{
+		UE_LOG(LogMockTrainer, Error, TEXT("Config has an invalid shared memory guid."));
+		return false;
+	}
+
+	Layout.MaxEpisodeNum = BufferObject->GetIntegerField(MaxEpisodeNumKey);
+	Layout.MaxStepNum = BufferObject->GetIntegerField(MaxStepNumKey);
+	Layout.ObservationDimNum = ReadVectorDimNum(*BufferObject, ObservationsKey);
+	Layout.ActionDimNum = ReadVectorDimNum(*BufferObject, ActionsKey);
+	Layout.MemoryStateDimNum = ReadVectorDimNum(*BufferObject, MemoryStatesKey);
+	Layout.RewardDimNum = FMath::Max(ReadVectorDimNum(*BufferObject, RewardsKey), 1);
+
+	// ReplayBufferSections 순서로 붙어 있고, 선택 section 은 config 에 false 로 적힌 경우만 빠진다
+	int64 BufferBytes = 0;
+	for (int32 SectionIndex = 0; SectionIndex < ReplayBufferSectionNum; ++SectionIndex)
+	{
+		const FReplayBufferSection& Section = ReplayBufferSections[SectionIndex];
+		bool bPresent = true;
+		if (Section.PresentKey)
+		{
+			BufferObject->TryGetBoolField(Section.PresentKey, bPresent);
+		}
+		Layout.bSectionPresent[SectionIndex] = bPresent;
+
+		BufferBytes += Layout.GetSectionByteNum(SectionIndex, Section.bPerEpisode ? Layout.MaxEpisodeNum : Layout.MaxStepNum);
+	}
+
+	return MapRegion(NetworkGuid, NetworkObject->GetIntegerField(MaxByteNumKey), Network)
+		&& MapRegion(BufferGuid, BufferBytes, ReplayBuffer);
+}
+
+int64 FMockTrainer::FReplayBufferLayout::GetElementByteNum(const MockTrainerProtocol::FReplayBufferSection& Section) const
+{
+	using namespace MockTrainerProtocol;
+
+	switch (Section.Element)
+	{
+	case EReplayBufferElement::Int32: return sizeof(int32);
+	case EReplayBufferElement::UInt8: return sizeof(uint8);
+	case EReplayBufferElement::Observation: return sizeof(float) * ObservationDimNum;
+	case EReplayBufferElement::Action: return sizeof(float) * ActionDimNum;
+	case EReplayBufferElement::MemoryState: return sizeof(float) * MemoryStateDimNum;
+	case EReplayBufferElement::Reward: return sizeof(float) * RewardDimNum;
+	}
+	return 0;
+}
+
+int64 FMockTrainer::FReplayBufferLayout::GetSectionByteNum(int32 SectionIndex, int64 ElementNum) const
+{
+	return bSectionPresent[SectionIndex] ?
+		ElementNum * GetElementByteNum(MockTrainerProtocol::ReplayBufferSections[SectionIndex]) : 0;
+}
+
+bool FMockTrainer::Open()
+{
+	if (!MapRegion(ControlsGuid, (int64)ProcessNum * MockTrainerProtocol::ControlNum * sizeof(int32), Controls))
+	{
+		return false;
+	}
+
+	UE_LOG(LogMockTrainer, Display, TEXT("Task %s: waiting for config from %d process(es)..."), *TaskName, ProcessNum);
+
+	// 게임은 config 파일을 다 쓴 다음에 ConfigSignal 을 올린다
+	const double WaitStart = FPlatformTime::Seconds();
+	while (!Control(MockTrainerProtocol::ConfigSignal))
+	{
+		if (FPlatformTime::Seconds() - WaitStart > IdleTimeoutSeconds)
+		{
+			UE_LOG(LogMockTrainer, Error, TEXT("Timed out waiting for config."));
+			return false;
+		}
+		FPlatformProcess::Sleep(SpinSeconds);
+	}
+
+	if (!LoadConfig())
+	{
+		return false;
+	}
+	Control(MockTrainerProtocol::ConfigSignal) = 0;
+
+	UE_LOG(LogMockTrainer, Display, TEXT("Config loaded: %d episodes x %d steps, obs %d, action %d, memory %d, network %lld bytes, weights %s."),
+		Layout.MaxEpisodeNum, Layout.MaxStepNum, Layout.ObservationDimNum, Layout.ActionDimNum, Layout.MemoryStateDimNum, Network.ByteNum,
+		WeightMode == EWeightMode::Random ? TEXT("random") : TEXT("fixed"));
+	return true;
+}
+
+volatile int32& FMockTrainer::Control(MockTrainerProtocol::EControl Index) const
+{
+	// ProcessNum 은 1 이라 block 하나뿐이다
+	return reinterpret_cast<volatile int32*>(Controls.Data)[Index];
+}
+
+void FMockTrainer::ReceiveNetwork()
+{
+	// 게임이 BeginTraining 에서 올린 초기 network 를 기억해 두고 그대로 / 흔들어서 돌려준다
+	InitialNetwork.SetNumUninitialized(Network.ByteNum);
+	FMemory::Memcpy(InitialNetwork.GetData(), Network.Data, Network.ByteNum);
+	Control(MockTrainerProtocol::NetworkSignal) = 0;
+
+	UE_LOG(LogMockTrainer, Display, TEXT("Received initial network (%lld bytes)."), Network.ByteNum);
+}
+
+void FMockTrainer::SendNetwork()
+{
+	if (InitialNetwork.Num() == Network.ByteNum)
+	{
+		FMemory::Memcpy(Network.Data, InitialNetwork.GetData(), Network.ByteNum);
+
+		if (WeightMode == EWeightMode::Random)
+		{
+			float* Weights = reinterpret_cast<float*>(Network.Data + NetworkHeaderByteNum);
+			const int64 WeightNum = (Network.ByteNum - NetworkHeaderByteNum) / sizeof(float);
+			for (int64 Index = 0; Index < WeightNum; ++Index)
+			{
+				if (FMath::IsFinite(Weights[Index]))
+				{
+					Weights[Index] += Random.FRandRange(-1e-3f, 1e-3f);
+				}
+			}
+		}
+	}
+
+	FPlatformMisc::MemoryBarrier();
+	Control(MockTrainerProtocol::NetworkSignal) = 1;
+	NetworksSent++;
+}
+
+void FMockTrainer::ConsumeExperience()
+{
+	const int32 EpisodeNum = FMath::Clamp<int32>(Control(MockTrainerProtocol::ExperienceEpisodeNum), 0, Layout.MaxEpisodeNum);
+	const int32 StepNum = FMath::Clamp<int32>(Control(MockTrainerProtocol::ExperienceStepNum), 0, Layout.MaxStepNum);
+
+	// section 마다 채워진 부분만 읽는다
+	const uint8* Cursor = ReplayBuffer.Data;
+	int64 Bytes = 0;
+	for (int32 SectionIndex = 0; SectionIndex < MockTrainerProtocol::ReplayBufferSectionNum; ++SectionIndex)
+	{
+		const bool bPerEpisode = MockTrainerProtocol::ReplayBufferSections[SectionIndex].bPerEpisode;
+		const int64 UsedBytes = Layout.GetSectionByteNum(SectionIndex, bPerEpisode ? EpisodeNum : StepNum);
+
+		Checksum += TouchBytes(Cursor, UsedBytes);
+		Bytes += UsedBytes;
+		Cursor += Layout.GetSectionByteNum(SectionIndex, bPerEpisode ? Layout.MaxEpisodeNum : Layout.MaxStepNum);
+	}
+
+	ExperienceBytes += Bytes;
+	ExperienceSteps += StepNum;
+	ExperienceBatches++;
+
+	Control(MockTrainerProtocol::ExperienceSignal) = 0;
+}
+
+int32 FMockTrainer::Run()
+{
+	using namespace MockTrainerProtocol;
+
+	StartTime = LastReportTime = FPlatformTime::Seconds();
+	double IdleStart = StartTime;
+
+	while (true)
+	{
+		if (Control(StopSignal))
+		{
+			break;
+		}
+
+		if (Control(PingSignal))
+		{
+			Control(PingSignal) = 0;
+		}
+
+		bool bWorked = false;
+		const double BusyStart = FPlatformTime::Seconds();
+
+		if (Control(NetworkSignal) && InitialNetwork.Num() == 0)
+		{
+			ReceiveNetwork();
+			bWorked = true;
+		}
+		else if (Control(NetworkRequestSignal))
+		{
+			Control(NetworkRequestSignal) = 0;
+			SendNetwork();
+			bWorked = true;
+		}
+		else if (Control(ExperienceSignal))
+		{
+			ConsumeExperience();
+
+			// 실제 trainer 처럼 experience 마다 갱신된 network 를 돌려준다
+			SendNetwork();
+			bWorked = true;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (bWorked)
+		{
+			// 게임이 신호를 주기 전까지 기다린 시간 = 게임 쪽 step 시간
+			const double Waited = BusyStart - IdleStart;
+			WaitSeconds += Waited;
+			LongestWaitSeconds = FMath::Max(LongestWaitSeconds, Waited);
+			ConsumeSeconds += Now - BusyStart;
+			IdleStart = Now;
+		}
+		else
+		{
+			if (Now - IdleStart > IdleTimeoutSeconds)
+			{
+				UE_LOG(LogMockTrainer, Warning, TEXT("No signal for %.0f seconds, assuming the game is gone."), IdleTimeoutSeconds);
+				break;
+			}
+			FPlatformProcess::Sleep(SpinSeconds);
+		}
+
+		if (ReportInterval > 0.f && Now - LastReportTime >= ReportInterval)
+		{
+			Report(false);
+			LastReportTime = Now;
+		}
+	}
+
+	Control(CompleteSignal) = 1;
+	Report(true);
+	return 0;
+}
+
+void FMockTrainer::Report(bool bFinal)
+{
+	const double Elapsed = FMath::Max(FPlatformTime::Seconds() - StartTime, 1e-6);
+
+	UE_LOG(LogMockTrainer, Display,
+		TEXT("%s %.1fs: %lld batches, %lld steps, %.2f MB/s, %.0f steps/s, %lld networks sent, trainer busy %.3fs, waiting on game %.3fs (longest %.3fs), checksum %llx"),
+		bFinal ? TEXT("Final") : TEXT("Report"), Elapsed,
+		ExperienceBatches, ExperienceSteps,
+		ExperienceBytes / Elapsed / (1024.0 * 1024.0), ExperienceSteps / Elapsed,
+		NetworksSent, ConsumeSeconds, WaitSeconds, LongestWaitSeconds, Checksum);
+}
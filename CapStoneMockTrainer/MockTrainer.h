@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "MockTrainerProtocol.h"
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformMemory.h"
+
+/**
+ * Python trainer 대신 붙는 native trainer.
+ * Experience 는 읽기만 하고 (모든 byte 를 한 번 훑는다) 학습은 하지 않는다.
+ * 게임 쪽 training 경로의 처리량과 trainer 를 기다리는 시간을 Python 없이 재기 위한 것이다.
+ */
+class FMockTrainer
+{
+public:
+	enum class EWeightMode : uint8
+	{
+		/** 게임이 처음 올린 network 를 그대로 돌려준다 */
+		Fixed,
+		/** 처음 network 의 float 값에 작은 noise 를 더해서 돌려준다 */
+		Random,
+	};
+
+	~FMockTrainer();
+
+	/** Parses the Python trainer's arguments plus -fixed, -random, -report=, -seed= */
+	bool ParseCommandLine(const TCHAR* CommandLine);
+
+	/** Opens the controls region and the regions listed in the config file */
+	bool Open();
+
+	/** Serves the game until StopSignal or the game process goes away. Returns the process exit code. */
+	int32 Run();
+
+private:
+	struct FRegion
+	{
+		FPlatformMemory::FSharedMemoryRegion* Region = nullptr;
+		uint8* Data = nullptr;
+		int64 ByteNum = 0;
+	};
+
+	struct FReplayBufferLayout
+	{
+		int32 MaxEpisodeNum = 0;
+		int32 MaxStepNum = 0;
+		int32 ObservationDimNum = 0;
+		int32 ActionDimNum = 0;
+		int32 MemoryStateDimNum = 0;
+		int32 RewardDimNum = 1;
+
+		// MockTrainerProtocol::ReplayBufferSections 순서
+		bool bSectionPresent[MockTrainerProtocol::ReplayBufferSectionNum] = {};
+
+		/** Bytes of one element of Section */
+		int64 GetElementByteNum(const MockTrainerProtocol::FReplayBufferSection& Section) const;
+
+		/** Bytes Section takes for ElementNum episodes or steps, 0 when the section is absent */
+		int64 GetSectionByteNum(int32 SectionIndex, int64 ElementNum) const;
+	};
+
+	bool MapRegion(const FGuid& Guid, int64 ByteNum, FRegion& OutRegion) const;
+	void UnmapRegion(FRegion& Region) const;
+
+	bool LoadConfig();
+
+	volatile int32& Control(MockTrainerProtocol::EControl Index) const;
+
+	void ReceiveNetwork();
+	void SendNetwork();
+	void ConsumeExperience();
+
+	void Report(bool bFinal);
+
+	FString TaskName;
+	FGuid ControlsGuid;
+	int32 ProcessNum = 1;
+	FString ConfigPath;
+
+	EWeightMode WeightMode = EWeightMode::Fixed;
+	float ReportInterval = 5.f;
+	int32 Seed = 0;
+
+	FRegion Controls;
+	FRegion Network;
+	FRegion ReplayBuffer;
+	FReplayBufferLayout Layout;
+
+	TArray<uint8> InitialNetwork;
+	FRandomStream Random;
+
+	// 통계
+	double StartTime = 0.0;
+	double LastReportTime = 0.0;
+	int64 ExperienceBytes = 0;
+	int64 ExperienceSteps = 0;
+	int64 ExperienceBatches = 0;
+	int64 NetworksSent = 0;
+	double ConsumeSeconds = 0.0;
+	double WaitSeconds = 0.0;
+	double LongestWaitSeconds = 0.0;
+	uint64 Checksum = 0;
+};
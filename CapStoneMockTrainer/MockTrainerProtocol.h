@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Learning Agents shared-memory trainer protocol, as the mock trainer understands it.
+ *
+ * 이 파일은 엔진의 LearningTraining 모듈 (LearningSharedMemoryTraining.cpp) 과
+ * Content/Python/shared_memory.py 가 쓰는 값을 옮겨 둔 것이다. 엔진 버전을 올리면 두 파일과 다시 맞춰야 한다.
+ *
+ * 실행 인자 (Python trainer 와 같은 위치):
+ *   CapStoneMockTrainer [<TrainerScript.py>] <TaskName> SharedMemory <ControlsGuid> <ProcessNum> <ConfigPath> [-fixed|-random] [-report=<seconds>]
+ * 엔진이 Python 대신 이 실행 파일을 띄우면 script 경로가 첫 인자로 오므로 건너뛴다. ProcessNum 은 1 만 지원한다.
+ *
+ * 1. Controls region (int32 x ControlNum, ProcessNum 개) 을 ControlsGuid 이름으로 연다.
+ * 2. ConfigPath 의 JSON 에서 network, experience buffer region 의 GUID 와 크기를 읽는다.
+ * 3. 게임이 ConfigSignal 을 올리면 config 를 확인하고 내린다.
+ * 4. NetworkRequestSignal 이면 policy bytes 를 network region 에 쓰고 NetworkSignal 을 올린다.
+ * 5. ExperienceSignal 이면 EpisodeNum, StepNum 만큼 experience 를 읽고 신호를 내린 뒤 새 network 를 보낸다.
+ * 6. StopSignal 이면 종료한다.
+ */
+namespace MockTrainerProtocol
+{
+	/** Slots of the controls region, one block of ControlNum int32 per process */
+	enum EControl : int32
+	{
+		ExperienceEpisodeNum = 0,
+		ExperienceStepNum = 1,
+		ExperienceSignal = 2,
+		ConfigSignal = 3,
+		NetworkRequestSignal = 4,
+		NetworkSignal = 5,
+		CompleteSignal = 6,
+		StopSignal = 7,
+		PingSignal = 8,
+		NetworkId = 9,
+		ReplayBufferId = 10,
+		ControlNum = 11,
+	};
+
+	// Config JSON 키
+	inline const TCHAR* NetworksKey = TEXT("Networks");
+	inline const TCHAR* ReplayBuffersKey = TEXT("ReplayBuffers");
+	inline const TCHAR* GuidKey = TEXT("Guid");
+	inline const TCHAR* MaxByteNumKey = TEXT("MaxByteNum");
+	inline const TCHAR* MaxEpisodeNumKey = TEXT("MaxEpisodeNum");
+	inline const TCHAR* MaxStepNumKey = TEXT("MaxStepNum");
+	inline const TCHAR* ObservationsKey = TEXT("Observations");
+	inline const TCHAR* ActionsKey = TEXT("Actions");
+	inline const TCHAR* RewardsKey = TEXT("Rewards");
+	inline const TCHAR* MemoryStatesKey = TEXT("MemoryStates");
+	inline const TCHAR* VectorDimNumKey = TEXT("VectorDimNum");
+
+	/** What one element of a replay buffer section holds */
+	enum class EReplayBufferElement : uint8
+	{
+		Int32,
+		UInt8,
+		Observation,
+		Action,
+		MemoryState,
+		Reward,
+	};
+
+	/** One array of the replay buffer region, sized by MaxEpisodeNum or MaxStepNum */
+	struct FReplayBufferSection
+	{
+		const TCHAR* Name;
+		bool bPerEpisode;
+		EReplayBufferElement Element;
+		// nullptr 이면 항상 있다. 아니면 config 의 이 bool 이 false 일 때 빠진다
+		const TCHAR* PresentKey;
+	};
+
+	/**
+	 * UE 5.5 replay buffer region 의 section 순서. LoadConfig 와 ConsumeExperience 가 같이 쓴다.
+	 * Memory state 가 없는 network 는 MemoryStates VectorDimNum 이 0 이라 해당 section 이 0 byte 가 된다.
+	 */
+	inline constexpr FReplayBufferSection ReplayBufferSections[] =
+	{
+		{ TEXT("EpisodeStarts"), true, EReplayBufferElement::Int32, nullptr },
+		{ TEXT("EpisodeLengths"), true, EReplayBufferElement::Int32, nullptr },
+		{ TEXT("EpisodeCompletionModes"), true, EReplayBufferElement::UInt8, TEXT("HasCompletions") },
+		{ TEXT("EpisodeFinalObservations"), true, EReplayBufferElement::Observation, TEXT("HasFinalObservations") },
+		{ TEXT("EpisodeFinalMemoryStates"), true, EReplayBufferElement::MemoryState, TEXT("HasFinalMemoryStates") },
+		{ TEXT("Observations"), false, EReplayBufferElement::Observation, nullptr },
+		{ TEXT("Actions"), false, EReplayBufferElement::Action, nullptr },
+		{ TEXT("MemoryStates"), false, EReplayBufferElement::MemoryState, nullptr },
+		{ TEXT("Rewards"), false, EReplayBufferElement::Reward, nullptr },
+	};
+
+	inline constexpr int32 ReplayBufferSectionNum = UE_ARRAY_COUNT(ReplayBufferSections);
+
+	/** Shared memory names are the GUID in braces, as FLearningSharedMemory creates them */
+	inline FString MakeRegionName(const FGuid& Guid)
+	{
+#if PLATFORM_WINDOWS
+		return TEXT("Global\\") + Guid.ToString(EGuidFormats::DigitsWithHyphensInBraces);
+#else
+		return Guid.ToString(EGuidFormats::DigitsWithHyphensInBraces);
+#endif
+	}
+}